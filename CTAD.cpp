@@ -5,77 +5,9 @@
  * have to explicitly specify them.
  */
 
-#include <cstddef>
-#include <cxxabi.h>
-#include <initializer_list>
-#include <iostream>
-#include <typeinfo>
-#include <vector>
-
-// A wrapper class around any type T.
-// Prints messages whenever constructors are invoked.
-template <class T> class TypedClass {
-  T val;
-
-public:
-  TypedClass() {
-    int status;
-    std::cout << "Default constructor of TypedClass<"
-              << abi::__cxa_demangle(typeid(T).name(), 0, 0, &status) << ">"
-              << std::endl;
-  }
-  TypedClass(const T &x) : val(x) {
-    int status;
-    std::cout << "Parameterized constructor of TypedClass<"
-              << abi::__cxa_demangle(typeid(T).name(), 0, 0, &status) << ">"
-              << std::endl;
-  }
-
-  // Explicit copy constructor: invoked when copying another TypedClass<T>
-  TypedClass(const TypedClass &obj) : val(obj.val) {
-    int status;
-    std::cout << "Copy constructor of TypedClass<"
-              << abi::__cxa_demangle(typeid(T).name(), 0, 0, &status) << ">"
-              << " with value " << val << std::endl;
-  }
-
-  // Getter
-  T getData() const { return val; }
-};
+#include "dynamicArray.hpp"
 
-// A wrapper around std::vector<T> with a few constructors
-template <class T> class DynamicArray {
-  std::vector<T> arr;
-
-public:
-  // Empty vector
-  DynamicArray() : arr() {}
-
-  // Constructs vector with 'sz' default-initialized Ts
-  DynamicArray(size_t sz) : arr(sz, T{}) {}
-
-  // Constructs vector from an initializer list {a, b, c, ...}
-  DynamicArray(std::initializer_list<T> init) : arr(init) {
-    int status;
-    std::cout << "Used initializer list in DynamicArray<"
-              << abi::__cxa_demangle(typeid(T).name(), 0, 0, &status) << ">"
-              << std::endl;
-  }
-
-  // Constructs vector with 'sz' copies of 'val'
-  DynamicArray(size_t sz, const T &val) : arr(sz, val) {}
-
-  // Getter
-  std::vector<T> &getArr() { return arr; }
-};
-
-// Deduction guide:
-// If DynamicArray(size_t, T) is called,
-// deduce DynamicArray<TypedClass<T>>.
-//
-// Example: DynamicArray(5, 1.3)
-//   -> becomes DynamicArray<TypedClass<double>>.
-template <typename T> DynamicArray(size_t, T) -> DynamicArray<TypedClass<T>>;
+#include <iostream>
 
 int main() {
   // Case 1: Single element {0} → deduces DynamicArray<int>
@@ -0,0 +1,130 @@
+// Replacement global operator new/delete for allocTracker.hpp.
+//
+// Every form is replaced (plain, array, nothrow, aligned) so that nothing can
+// slip past the counters, and all of them go straight to malloc/free. An
+// allocation is counted once it has succeeded, so one that ends in
+// bad_alloc isn't.
+
+#include "allocTracker.hpp"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+struct Install {
+  Install() { allocTracker::hooksLinked = true; }
+} install;
+
+inline void noteAlloc(std::size_t n) {
+  auto &t = allocTracker::tls;
+  if (t.activeScopes) [[unlikely]] {
+    ++t.counts.allocations;
+    t.counts.bytes += n;
+  }
+}
+
+inline void noteFree(void *p) {
+  auto &t = allocTracker::tls;
+  if (p && t.activeScopes) [[unlikely]]
+    ++t.counts.deallocations;
+}
+
+void *allocate(std::size_t n) {
+  for (;;) {
+    if (void *p = std::malloc(n ? n : 1)) {
+      noteAlloc(n);
+      return p;
+    }
+    std::new_handler h = std::get_new_handler();
+    if (!h)
+      throw std::bad_alloc();
+    h();
+  }
+}
+
+void *allocate(std::size_t n, std::align_val_t al) {
+  std::size_t a = static_cast<std::size_t>(al);
+  if (a < sizeof(void *))
+    a = sizeof(void *);
+  for (;;) {
+    void *p = nullptr;
+    if (posix_memalign(&p, a, n ? n : 1) == 0) {
+      noteAlloc(n);
+      return p;
+    }
+    std::new_handler h = std::get_new_handler();
+    if (!h)
+      throw std::bad_alloc();
+    h();
+  }
+}
+
+void release(void *p) noexcept {
+  noteFree(p);
+  std::free(p);
+}
+} // namespace
+
+// GCC can't tell that the replaced new above is what pairs with free()
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void *operator new(std::size_t n) { return allocate(n); }
+void *operator new[](std::size_t n) { return allocate(n); }
+void *operator new(std::size_t n, std::align_val_t al) { return allocate(n, al); }
+void *operator new[](std::size_t n, std::align_val_t al) {
+  return allocate(n, al);
+}
+
+void *operator new(std::size_t n, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t n, const std::nothrow_t &) noexcept {
+  try {
+    return allocate(n);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new(std::size_t n, std::align_val_t al,
+                   const std::nothrow_t &) noexcept {
+  try {
+    return allocate(n, al);
+  } catch (...) {
+    return nullptr;
+  }
+}
+void *operator new[](std::size_t n, std::align_val_t al,
+                     const std::nothrow_t &) noexcept {
+  try {
+    return allocate(n, al);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void operator delete(void *p) noexcept { release(p); }
+void operator delete[](void *p) noexcept { release(p); }
+void operator delete(void *p, std::size_t) noexcept { release(p); }
+void operator delete[](void *p, std::size_t) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t) noexcept { release(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { release(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+  release(p);
+}
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+  release(p);
+}
+void operator delete(void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete[](void *p, const std::nothrow_t &) noexcept { release(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t &) noexcept {
+  release(p);
+}
+void operator delete[](void *p, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  release(p);
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+// Opt-in heap allocation tracking.
+//
+// Link allocTracker.cpp into a program to replace the global operator
+// new/delete with versions that count, per thread, how many allocations and
+// how many bytes are requested while an AllocScope is alive on that thread:
+//
+//   AllocScope scope;
+//   std::vector<int> destination = std::move(source);
+//   assert(scope.allocations() == 0);
+//
+// Outside of any scope the replaced operators cost one thread-local load and
+// a branch on top of malloc/free. Without allocTracker.cpp nothing is
+// replaced at all; scopes still compile but always report zero, which
+// allocTrackingAvailable() lets callers detect.
+
+#include <cstdint>
+
+struct AllocCounts {
+  uint64_t allocations = 0;
+  uint64_t deallocations = 0;
+  uint64_t bytes = 0; // requested by the allocations, not freed
+
+  AllocCounts operator-(const AllocCounts &o) const {
+    return {allocations - o.allocations, deallocations - o.deallocations,
+            bytes - o.bytes};
+  }
+};
+
+namespace allocTracker {
+// Cumulative counts of this thread, advanced only while a scope is active.
+// Trivial and constant-initialized, so the hooks can touch it at any point
+// in a thread's lifetime.
+struct ThreadState {
+  AllocCounts counts;
+  uint32_t activeScopes = 0;
+};
+inline thread_local constinit ThreadState tls;
+
+// Set by allocTracker.cpp's static initializer when the hooks are linked in
+inline bool hooksLinked = false;
+} // namespace allocTracker
+
+inline bool allocTrackingAvailable() { return allocTracker::hooksLinked; }
+
+// Counts this thread's allocations from construction until destruction.
+// Scopes nest; an inner scope's allocations are also seen by outer ones.
+class AllocScope {
+  AllocCounts start;
+
+public:
+  AllocScope() {
+    ++allocTracker::tls.activeScopes;
+    start = allocTracker::tls.counts;
+  }
+  ~AllocScope() { --allocTracker::tls.activeScopes; }
+  AllocScope(const AllocScope &) = delete;
+  AllocScope &operator=(const AllocScope &) = delete;
+
+  // Everything counted since the scope began (or since the last reset())
+  AllocCounts counts() const { return allocTracker::tls.counts - start; }
+  uint64_t allocations() const { return counts().allocations; }
+  uint64_t deallocations() const { return counts().deallocations; }
+  uint64_t bytes() const { return counts().bytes; }
+
+  void reset() { start = allocTracker::tls.counts; }
+};
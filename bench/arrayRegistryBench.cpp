@@ -0,0 +1,121 @@
+// What TrackedDynamicArray's registration costs over a plain DynamicArray,
+// for short-lived arrays: a workload creating 10^6 arrays a second spends
+// (tracked - plain) ns/array * 10^6 / 10^9 of a core on the accounting, so
+// 50ns of difference is 5% of one core. The registry's figures are checked
+// against a known set of arrays first, and the top consumers of the
+// benchmarks' own arrays are printed at exit.
+
+#include "../trackedDynamicArray.hpp"
+#include "benchHarness.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using TypedDouble = TypedClass<double, SilentPolicy>;
+
+static void checkRegistry() {
+  std::vector<TrackedDynamicArray<int>> ints;
+  const unsigned intsLine = __LINE__ + 2;
+  for (int i = 0; i < 3; ++i) {
+    ints.push_back(TrackedDynamicArray<int>()); // moved in, keeping the tag
+    ints.back().reserve(8);
+    ints.back().push_back(i);
+  }
+  const unsigned bigLine = __LINE__ + 1;
+  TrackedDynamicArray<TypedDouble> big(1000, TypedDouble(1.0));
+  big.reserve(1500);
+
+  auto usage = arrayRegistry().top();
+  if (usage.size() != 2)
+    bench::fail("expected two type/site pairs");
+  const auto &d = usage[0], &i = usage[1];
+  if (d.arrays != 1 || d.elements != 1000 || d.capacity != 1500 ||
+      d.bytes != 1500 * sizeof(TypedDouble) ||
+      d.slackBytes != 500 * sizeof(TypedDouble) || d.site.line() != bigLine)
+    bench::fail("wrong figures for the TypedDouble array");
+  if (i.arrays != 3 || i.elements != 3 || i.capacity != 24 ||
+      i.bytes != 24 * sizeof(int) || i.site.line() != intsLine)
+    bench::fail("wrong figures for the int arrays");
+
+  TrackedDynamicArray<TypedDouble> moved = std::move(big);
+  usage = arrayRegistry().top(1);
+  // big is left registered, but empty
+  if (usage[0].arrays != 2 || usage[0].bytes != 1500 * sizeof(TypedDouble))
+    bench::fail("a move changed the figures");
+  TrackedDynamicArray<TypedDouble> assigned;
+  assigned = std::move(moved);
+  if (assigned.site().line() != bigLine)
+    bench::fail("move assignment didn't take the source's site");
+  ints.clear();
+  if (arrayRegistry().top().size() != 1)
+    bench::fail("destroyed arrays are still registered");
+}
+
+BENCHMARK_CHECK(checkRegistry);
+
+// Held for the whole run, so the dump at exit has something to show
+static TrackedDynamicArray<TypedDouble> longLived(4096, TypedDouble(0.0));
+
+// Registered after longLived (and the registry) exist, so it runs before
+// they're destroyed
+[[maybe_unused]] static const bool dumped = [] {
+  std::atexit([] {
+    std::cout << "\nLive arrays at exit:\n";
+    arrayRegistry().dumpTop(std::cout);
+  });
+  return true;
+}();
+
+// One array of range(0) ints per item, built up by push_back
+template <class Array> static void churn(bench::State &state) {
+  for (auto _ : state) {
+    Array a;
+    for (int64_t i = 0; i < state.range(0); ++i)
+      a.push_back(static_cast<int>(i));
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(churn, DynamicArray<int>)->rangeMultiplier(4)->range(1, 64);
+BENCHMARK_TEMPLATE(churn, TrackedDynamicArray<int>)
+    ->rangeMultiplier(4)
+    ->range(1, 64);
+
+// The same with range(0) threads at once, each on its own shard
+template <class Array> static void churnThreads(bench::State &state) {
+  constexpr int kPerThread = 1 << 15;
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int64_t t = 0; t < state.range(0); ++t)
+      threads.emplace_back([] {
+        for (int i = 0; i < kPerThread; ++i) {
+          Array a;
+          a.push_back(i);
+          bench::doNotOptimize(a.data());
+        }
+      });
+    for (auto &t : threads)
+      t.join();
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0) * kPerThread);
+}
+BENCHMARK_TEMPLATE(churnThreads, DynamicArray<int>)
+    ->rangeMultiplier(2)
+    ->range(1, 8);
+BENCHMARK_TEMPLATE(churnThreads, TrackedDynamicArray<int>)
+    ->rangeMultiplier(2)
+    ->range(1, 8);
+
+// What a report costs with 10^4 arrays live
+static void topConsumers(bench::State &state) {
+  std::vector<TrackedDynamicArray<int>> live(10'000);
+  for (auto _ : state)
+    bench::doNotOptimize(arrayRegistry().top(10));
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(topConsumers);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,406 @@
+#pragma once
+
+// A small, dependency-free benchmark harness modelled on google-benchmark.
+//
+//   static void sumInts(bench::State &state) {
+//     DynamicArray<int> a(state.range(0), 1);
+//     for (auto _ : state)
+//       bench::doNotOptimize(std::accumulate(a.begin(), a.end(), 0));
+//     state.setItemsProcessed(state.iterations() * state.range(0));
+//   }
+//   BENCHMARK(sumInts)->range(8, 1 << 20);
+//   BENCHMARK_MAIN();
+//
+// Each benchmark is re-run with a growing iteration count until one run takes
+// at least --min-time seconds; the numbers of that final run are reported.
+// Command line: --filter=<regex> --min-time=<seconds> --format=console|csv
+//               --perf --list
+//
+// --perf adds hardware counters (perfCounters.hpp) for the timed region, per
+// iteration: cycles, instructions, IPC, L1D/LLC/dTLB and branch misses.
+// Counters the machine won't give us are left out, with a note on stderr.
+//
+// A benchmark checks what it measures before main() runs, so a broken
+// build fails even with --filter=^$ (which is how ctest runs it):
+//
+//   static void checkSums() {
+//     if (sum(DynamicArray<int>(4, 1)) != 4)
+//       bench::fail("wrong sum");
+//   }
+//   BENCHMARK_CHECK(checkSums);
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <memory>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "../perfCounters.hpp"
+
+namespace bench {
+
+// Keeps the compiler from discarding a value it can prove is unused
+template <class T> inline void doNotOptimize(const T &value) {
+  if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void *))
+    asm volatile("" : : "r,m"(value) : "memory");
+  else
+    asm volatile("" : : "m"(value) : "memory");
+}
+template <class T> inline void doNotOptimize(T &value) {
+  if constexpr (std::is_trivially_copyable_v<T> && sizeof(T) <= sizeof(void *))
+    asm volatile("" : "+r,m"(value) : : "memory");
+  else
+    asm volatile("" : "+m"(value) : : "memory");
+}
+// Forces all pending writes to be considered visible
+inline void clobberMemory() { asm volatile("" : : : "memory"); }
+
+// The BENCHMARK_CHECK running, for fail() to name
+inline const char *runningCheck = "check";
+
+// Reports a failed check and stops: it's before main(), where there's no
+// one to throw to
+[[noreturn]] inline void fail(const char *what) {
+  std::fprintf(stderr, "%s: %s\n", runningCheck, what);
+  std::abort();
+}
+
+inline bool runCheck(const char *name, void (*check)()) {
+  runningCheck = name;
+  check();
+  runningCheck = "check";
+  return true;
+}
+
+struct Counter {
+  enum Flags {
+    Default = 0,
+    AvgIterations = 1, // value is divided by the iteration count
+    IsRate = 2,        // value is divided by the elapsed seconds
+  };
+  double value = 0;
+  int flags = Default;
+
+  Counter() = default;
+  Counter(double v, int f = Default) : value(v), flags(f) {}
+};
+
+class State {
+  using Clock = std::chrono::steady_clock;
+
+  std::vector<int64_t> args;
+  int64_t maxIters;
+  Clock::time_point started;
+  Clock::duration elapsed{};
+  int64_t items = 0;
+  int64_t bytes = 0;
+  const PerfCounters *perf;
+  PerfSample perfStarted;
+  PerfSample perfElapsed;
+
+public:
+  std::map<std::string, Counter> counters;
+  std::string label;
+
+  State(std::vector<int64_t> args, int64_t iters,
+        const PerfCounters *perf = nullptr)
+      : args(std::move(args)), maxIters(iters), perf(perf) {}
+
+  int64_t range(size_t i = 0) const { return args.at(i); }
+  int64_t iterations() const { return maxIters; }
+
+  void setItemsProcessed(int64_t n) { items = n; }
+  void setBytesProcessed(int64_t n) { bytes = n; }
+  void setLabel(std::string l) { label = std::move(l); }
+
+  void pauseTiming() {
+    elapsed += Clock::now() - started;
+    if (perf)
+      perfElapsed += perf->read() - perfStarted;
+  }
+  void resumeTiming() {
+    if (perf)
+      perfStarted = perf->read();
+    started = Clock::now();
+  }
+
+  double seconds() const {
+    return std::chrono::duration<double>(elapsed).count();
+  }
+  int64_t itemsProcessed() const { return items; }
+  int64_t bytesProcessed() const { return bytes; }
+  const PerfSample &perfCounts() const { return perfElapsed; }
+
+  // Supports `for (auto _ : state)`: the timer runs from the first call to
+  // begin() until the loop condition fails. Value has a user-provided
+  // destructor only so that `_` doesn't trigger unused-variable warnings.
+  struct Value {
+    ~Value() {}
+  };
+  class Iterator {
+    State *st;
+    int64_t left;
+
+  public:
+    Iterator(State *s, int64_t n) : st(s), left(n) {}
+    Value operator*() const { return {}; }
+    Iterator &operator++() {
+      --left;
+      return *this;
+    }
+    bool operator!=(const Iterator &) const {
+      if (left > 0) [[likely]]
+        return true;
+      st->pauseTiming();
+      return false;
+    }
+  };
+  Iterator begin() {
+    resumeTiming();
+    return {this, maxIters};
+  }
+  Iterator end() { return {this, 0}; }
+};
+
+using Function = std::function<void(State &)>;
+
+class Benchmark {
+  std::string benchName;
+  Function fn;
+  std::vector<std::vector<int64_t>> argSets;
+  int multiplier = 8;
+
+  // Registration runs before main(), where there's no one to throw to
+  [[noreturn]] void misuse(const char *what) const {
+    std::fprintf(stderr, "%s: %s\n", benchName.c_str(), what);
+    std::abort();
+  }
+
+public:
+  Benchmark(std::string name, Function f)
+      : benchName(std::move(name)), fn(std::move(f)) {}
+
+  Benchmark *arg(int64_t a) {
+    argSets.push_back({a});
+    return this;
+  }
+  Benchmark *args(std::vector<int64_t> a) {
+    argSets.push_back(std::move(a));
+    return this;
+  }
+  Benchmark *rangeMultiplier(int m) {
+    if (m < 2)
+      misuse("rangeMultiplier() needs a multiplier of at least 2");
+    multiplier = m;
+    return this;
+  }
+  // lo, lo*m, lo*m^2, ... and finally hi; from lo == 0 the next one is 1
+  Benchmark *range(int64_t lo, int64_t hi) {
+    if (lo < 0)
+      misuse("range() needs lo >= 0");
+    if (lo == 0 && hi > 0)
+      argSets.push_back({0});
+    for (int64_t a = std::max<int64_t>(lo, 1); a < hi;
+         a = a > hi / multiplier ? hi : a * multiplier)
+      argSets.push_back({a});
+    argSets.push_back({hi});
+    return this;
+  }
+
+  const std::string &name() const { return benchName; }
+  const Function &function() const { return fn; }
+  std::vector<std::vector<int64_t>> argumentSets() const {
+    return argSets.empty() ? std::vector<std::vector<int64_t>>{{}} : argSets;
+  }
+};
+
+inline std::vector<std::unique_ptr<Benchmark>> &registry() {
+  static std::vector<std::unique_ptr<Benchmark>> r;
+  return r;
+}
+
+inline Benchmark *registerBenchmark(std::string name, Function fn) {
+  registry().push_back(std::make_unique<Benchmark>(std::move(name), std::move(fn)));
+  return registry().back().get();
+}
+
+struct Result {
+  std::string name;
+  int64_t iterations;
+  double nsPerIter;
+  std::map<std::string, double> counters;
+};
+
+inline std::string runName(const Benchmark &b, const std::vector<int64_t> &args) {
+  std::string n = b.name();
+  for (int64_t a : args) {
+    n += '/';
+    n += std::to_string(a);
+  }
+  return n;
+}
+
+inline Result runOne(const Benchmark &b, const std::vector<int64_t> &args,
+                     double minTime, const PerfCounters *perf = nullptr) {
+  int64_t iters = 1;
+  for (;;) {
+    State st(args, iters, perf);
+    b.function()(st);
+    double secs = st.seconds();
+    if (secs >= minTime || iters >= 1'000'000'000) {
+      Result r{runName(b, args), iters, secs * 1e9 / double(iters), {}};
+      if (st.itemsProcessed())
+        r.counters["items/s"] = double(st.itemsProcessed()) / secs;
+      if (st.bytesProcessed())
+        r.counters["bytes/s"] = double(st.bytesProcessed()) / secs;
+      for (const auto &[k, c] : st.counters) {
+        double v = c.value;
+        if (c.flags & Counter::AvgIterations)
+          v /= double(iters);
+        if (c.flags & Counter::IsRate)
+          v /= secs;
+        r.counters[k] = v;
+      }
+      const PerfSample &pc = st.perfCounts();
+      for (size_t i = 0; i < kPerfEvents; ++i)
+        if (pc.valid[i])
+          r.counters[perfEventName(PerfEvent(i))] = pc.values[i] / double(iters);
+      if (pc.has(PerfEvent::Cycles) && pc.has(PerfEvent::Instructions) &&
+          pc[PerfEvent::Cycles] > 0)
+        r.counters["IPC"] = pc[PerfEvent::Instructions] / pc[PerfEvent::Cycles];
+      if (!st.label.empty())
+        r.name += " " + st.label;
+      return r;
+    }
+    // Aim a little past minTime, but never grow by more than 10x at once
+    double guess = secs > 0 ? minTime * 1.4 / secs * double(iters) : 10.0 * iters;
+    iters = std::clamp<int64_t>(int64_t(guess), iters + 1, iters * 10);
+  }
+}
+
+inline std::string humanize(double v) {
+  static const char *suffix[] = {"", "k", "M", "G", "T"};
+  int i = 0;
+  while (v >= 1000 && i < 4) {
+    v /= 1000;
+    ++i;
+  }
+  char buf[32];
+  std::snprintf(buf, sizeof buf, "%.4g%s", v, suffix[i]);
+  return buf;
+}
+
+inline void printResult(const Result &r) {
+  std::printf("%-48s %14.1f ns %12lld", r.name.c_str(), r.nsPerIter,
+              static_cast<long long>(r.iterations));
+  for (const auto &[k, v] : r.counters)
+    std::printf(" %s=%s", k.c_str(), humanize(v).c_str());
+  std::printf("\n");
+  std::fflush(stdout);
+}
+
+// name,iterations,ns_per_iter,counters with counters as space-separated
+// key=value pairs; the name is quoted since template arguments have commas
+inline void printCsvResult(const Result &r) {
+  std::printf("\"%s\",%lld,%.3f,\"", r.name.c_str(),
+              static_cast<long long>(r.iterations), r.nsPerIter);
+  const char *sep = "";
+  for (const auto &[k, v] : r.counters) {
+    std::printf("%s%s=%.6g", sep, k.c_str(), v);
+    sep = " ";
+  }
+  std::printf("\"\n");
+  std::fflush(stdout);
+}
+
+inline int runSpecifiedBenchmarks(int argc, char **argv) {
+  std::regex filter(".*");
+  double minTime = 0.5;
+  bool listOnly = false;
+  bool csv = false;
+  bool usePerf = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view a = argv[i];
+    if (a.starts_with("--filter="))
+      filter = std::regex(std::string(a.substr(9)));
+    else if (a.starts_with("--min-time="))
+      minTime = std::atof(argv[i] + 11);
+    else if (a == "--format=csv")
+      csv = true;
+    else if (a == "--format=console")
+      csv = false;
+    else if (a == "--perf")
+      usePerf = true;
+    else if (a == "--list")
+      listOnly = true;
+    else {
+      std::fprintf(stderr,
+                   "usage: %s [--filter=<regex>] [--min-time=<s>] "
+                   "[--format=console|csv] [--perf] [--list]\n",
+                   argv[0]);
+      return 1;
+    }
+  }
+
+  std::unique_ptr<PerfCounters> perf;
+  if (usePerf && !listOnly) {
+    perf = std::make_unique<PerfCounters>();
+    if (!perf->error().empty())
+      std::fprintf(stderr, "note: %s%s\n", perf->error().c_str(),
+                   perf->available() ? " (reporting the other counters)"
+                                     : "; no hardware counters");
+    if (!perf->available())
+      perf.reset();
+  }
+
+  if (csv && !listOnly) {
+    std::printf("name,iterations,ns_per_iter,counters\n");
+  } else if (!listOnly) {
+    std::printf("%-48s %17s %12s\n", "Benchmark", "Time", "Iterations");
+    std::printf("%s\n", std::string(79, '-').c_str());
+  }
+  for (const auto &b : registry())
+    for (const auto &args : b->argumentSets()) {
+      std::string n = runName(*b, args);
+      if (!std::regex_search(n, filter))
+        continue;
+      if (listOnly)
+        std::printf("%s\n", n.c_str());
+      else if (csv)
+        printCsvResult(runOne(*b, args, minTime, perf.get()));
+      else
+        printResult(runOne(*b, args, minTime, perf.get()));
+    }
+  return 0;
+}
+
+} // namespace bench
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+#define BENCHMARK(fn)                                                          \
+  [[maybe_unused]] static ::bench::Benchmark *BENCH_CONCAT(                    \
+      benchRegistration_, __COUNTER__) = ::bench::registerBenchmark(#fn, fn)
+
+#define BENCHMARK_TEMPLATE(fn, ...)                                            \
+  [[maybe_unused]] static ::bench::Benchmark *BENCH_CONCAT(                    \
+      benchRegistration_, __COUNTER__) =                                          \
+      ::bench::registerBenchmark(#fn "<" #__VA_ARGS__ ">", fn<__VA_ARGS__>)
+
+#define BENCHMARK_CHECK(fn)                                                    \
+  [[maybe_unused]] static const bool BENCH_CONCAT(benchCheck_, __COUNTER__) = \
+      ::bench::runCheck(#fn, fn)
+
+#define BENCHMARK_MAIN()                                                       \
+  int main(int argc, char **argv) {                                            \
+    return ::bench::runSpecifiedBenchmarks(argc, argv);                        \
+  }
@@ -0,0 +1,133 @@
+// Churning same-sized DynamicArrays with malloc behind them against the
+// size-class pool of bufferPool.hpp: one array at a time, a window of
+// arrays replaced in random order, and arrays built on one thread and
+// destroyed on another, which sends every buffer through the depot.
+//
+// rssMB is the process's resident set after the run, in MB. It only grows
+// over a run of several benchmarks, so compare it across separate runs:
+//   bufferPoolBench --filter='<DynamicArray'  and  --filter=Pooled
+//
+// The pool is checked for handing out a buffer twice first.
+
+#include "../bufferPool.hpp"
+#include "benchHarness.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Enough buffers of each class to overflow the thread's stack and fill the
+// depot, allocated twice over; every live buffer has to be distinct
+static void checkPool() {
+  for (unsigned c = 0; c < bufferPool::kClasses; c += 3) {
+    size_t bytes = bufferPool::classBytes(c);
+    std::vector<void *> live;
+    for (int round = 0; round < 2; ++round) {
+      for (int i = 0; i < 2000; ++i)
+        live.push_back(bufferPool::allocate(bytes));
+      std::vector<void *> sorted = live;
+      std::sort(sorted.begin(), sorted.end());
+      if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+        bench::fail("a buffer was handed out twice");
+      for (size_t i = 0; i < live.size(); i += 2)
+        bufferPool::deallocate(live[i], bytes);
+      std::erase_if(live, [&, i = size_t(0)](void *) mutable {
+        return i++ % 2 == 0;
+      });
+    }
+    for (void *p : live)
+      bufferPool::deallocate(p, bytes);
+  }
+}
+
+BENCHMARK_CHECK(checkPool);
+
+static double residentMB() {
+  long pages = 0, resident = 0;
+  if (FILE *f = std::fopen("/proc/self/statm", "r")) {
+    if (std::fscanf(f, "%ld %ld", &pages, &resident) != 2)
+      resident = 0;
+    std::fclose(f);
+  }
+  return double(resident) * double(sysconf(_SC_PAGESIZE)) / (1 << 20);
+}
+
+template <class Array> static void churn(bench::State &state) {
+  for (auto _ : state) {
+    Array a(size_t(state.range(0)));
+    bench::doNotOptimize(a.data());
+  }
+  state.counters["rssMB"] = residentMB();
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(churn, DynamicArray<int>)->range(16, 1 << 16);
+BENCHMARK_TEMPLATE(churn, PooledDynamicArray<int>)->range(16, 1 << 16);
+
+// 4096 live arrays of random sizes up to range(0), one replaced per item
+template <class Array> static void window(bench::State &state) {
+  std::vector<Array> live(4096);
+  uint64_t s = 88172645463325252ull;
+  for (auto _ : state) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    live[s % live.size()] = Array(size_t(s >> 32) % size_t(state.range(0)) + 1);
+  }
+  state.counters["rssMB"] = residentMB();
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(window, DynamicArray<int>)->range(64, 1 << 14);
+BENCHMARK_TEMPLATE(window, PooledDynamicArray<int>)->range(64, 1 << 14);
+
+// Built here, destroyed on a consumer thread, 256 arrays at a time
+template <class Array> static void handoff(bench::State &state) {
+  constexpr size_t kBatch = 256;
+  std::mutex lock;
+  std::condition_variable ready;
+  std::vector<Array> inbox;
+  bool done = false;
+  std::thread consumer([&] {
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+      ready.wait(guard, [&] { return !inbox.empty() || done; });
+      if (inbox.empty())
+        return;
+      std::vector<Array> batch = std::move(inbox);
+      inbox.clear();
+      guard.unlock();
+      batch.clear(); // the arrays die on this thread
+      guard.lock();
+    }
+  });
+  std::vector<Array> batch;
+  for (auto _ : state) {
+    batch.emplace_back(size_t(state.range(0)));
+    if (batch.size() == kBatch) {
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        for (Array &a : batch)
+          inbox.push_back(std::move(a));
+      }
+      batch.clear();
+      ready.notify_one();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(lock);
+    done = true;
+  }
+  ready.notify_one();
+  consumer.join();
+  state.counters["rssMB"] = residentMB();
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(handoff, DynamicArray<int>)->range(16, 1 << 12);
+BENCHMARK_TEMPLATE(handoff, PooledDynamicArray<int>)->range(16, 1 << 12);
+
+BENCHMARK_MAIN();
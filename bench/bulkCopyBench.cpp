@@ -0,0 +1,90 @@
+// Copy-constructing a DynamicArray<double> (one memmove through the cache)
+// against a BulkCopyDynamicArray<double> (bulkCopy.hpp) on 1 to 8 threads,
+// for an array that fits in the last-level cache and one that doesn't.
+// range(0) is the array's size in MB, range(1) the thread count.
+//
+// hotScanNs is the time to read through an 8MB working set right after
+// each copy: what the copy left of it in the cache.
+//
+// bulkCopy::copy is checked against memcpy first, at unaligned offsets and
+// on several threads.
+
+#include "../bulkCopy.hpp"
+#include "benchHarness.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+static void checkCopy() {
+  // Past the cache, so it streams, and across three threads' parts
+  size_t bytes = std::max(bulkCopy::lastLevelCacheBytes() + 4099,
+                          3 * bulkCopy::kMinBytesPerThread + 13);
+  std::vector<char> src(bytes + 64), dst(bytes + 64);
+  for (size_t i = 0; i < src.size(); ++i)
+    src[i] = char(i * 2654435761u >> 13);
+  for (size_t off : {0, 1, 7, 33}) {
+    std::memset(dst.data(), 0, dst.size());
+    bulkCopy::copy(dst.data() + off, src.data() + 3, bytes - off, 3);
+    if (std::memcmp(dst.data() + off, src.data() + 3, bytes - off) != 0)
+      bench::fail("copy() differs from memcpy");
+    if (dst[off + bytes - off] != 0 || (off && dst[off - 1] != 0))
+      bench::fail("copy() wrote outside the destination");
+  }
+  for (size_t n : {0, 1, 15, 64, 100, 4097}) {
+    std::memset(dst.data(), 0, n + 32);
+    bulkCopy::streamCopy(dst.data() + 5, src.data(), n);
+    if (std::memcmp(dst.data() + 5, src.data(), n) != 0 || dst[5 + n] != 0)
+      bench::fail("streamCopy() differs from memcpy");
+  }
+
+  BulkCopyDynamicArray<double> a(size_t(5) << 20, 1.5);
+  a[12345] = 2.5;
+  uint64_t before = bulkCopy::copies;
+  BulkCopyDynamicArray<double> b(a);
+  if (bulkCopy::copies != before + 1)
+    bench::fail("BulkCopyDynamicArray's copy bypassed bulkCopy::copy()");
+  if (b.size() != a.size() || b.getArr() != a.getArr())
+    bench::fail("BulkCopyDynamicArray's copy differs from the original");
+  before = bulkCopy::copies;
+  DynamicArray<double> c(size_t(1) << 10, 1.5), d(c);
+  if (bulkCopy::copies != before || d.getArr() != c.getArr())
+    bench::fail("DynamicArray's copy went through bulkCopy::copy()");
+}
+
+BENCHMARK_CHECK(checkCopy);
+
+template <class Array> static void copyConstruct(bench::State &state) {
+  size_t n = (size_t(state.range(0)) << 20) / sizeof(double);
+  bulkCopy::defaultThreads = unsigned(state.range(1));
+  Array src(n, 1.0);
+  std::vector<uint64_t> hot(size_t(8) << 20 >> 3, 1);
+  double hotNs = 0;
+  for (auto _ : state) {
+    Array copy(src);
+    bench::doNotOptimize(copy.data());
+    state.pauseTiming();
+    auto t0 = std::chrono::steady_clock::now();
+    bench::doNotOptimize(std::accumulate(hot.begin(), hot.end(), uint64_t(0)));
+    hotNs += std::chrono::duration<double, std::nano>(
+                 std::chrono::steady_clock::now() - t0)
+                 .count();
+    state.resumeTiming();
+  }
+  bulkCopy::defaultThreads = 0;
+  state.counters["hotScanNs"] = hotNs / double(state.iterations());
+  state.setBytesProcessed(state.iterations() * int64_t(n * sizeof(double)));
+}
+BENCHMARK_TEMPLATE(copyConstruct, DynamicArray<double>)
+    ->args({16, 1})
+    ->args({1024, 1});
+BENCHMARK_TEMPLATE(copyConstruct, BulkCopyDynamicArray<double>)
+    ->args({16, 1})
+    ->args({1024, 1})
+    ->args({1024, 2})
+    ->args({1024, 4})
+    ->args({1024, 8});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,180 @@
+// range(0) threads doing lookups and updates on a map of 64K keys, with
+// range(1) percent of the operations writes (half assign, half erase):
+// ConcurrentHashMap against a std::unordered_map behind a std::shared_mutex.
+//
+// First checked: typeId<T>() tells the types of a TypeList apart at compile
+// time; Id<T> handles work as keys; and readers racing writers that resize the map find every key that
+// was inserted before they looked, with its value.
+
+#include "../concurrentHashMap.hpp"
+#include "../slotMap.hpp"
+#include "../typeList.hpp"
+#include "../typedClass.hpp"
+#include "../typeUtils.hpp"
+#include "benchHarness.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using IdTypes = TypeList<int, unsigned, double, Id<float>, Id<double>,
+                         TypedClass<double>, TypedClass<double, SilentPolicy>>;
+
+template <class List> struct DistinctIds;
+template <class... Ts> struct DistinctIds<TypeList<Ts...>> {
+  static constexpr bool value = [] {
+    uint64_t ids[] = {typeId<Ts>()...};
+    for (size_t i = 0; i < sizeof...(Ts); ++i)
+      for (size_t j = 0; j < i; ++j)
+        if (ids[i] == ids[j] || ids[i] == 0)
+          return false;
+    return true;
+  }();
+};
+static_assert(DistinctIds<IdTypes>::value, "two types share a typeId");
+
+static uint64_t keyOf(uint64_t i) { return i * 0x9e3779b97f4a7c15ull + 1; }
+
+static void checkMap() {
+  ConcurrentHashMap<uint64_t, uint32_t> byType;
+  uint32_t n = 0;
+  forEachType<IdTypes>([&]<class T>() { byType.insert(typeId<T>(), n++); });
+  if (byType.size() != IdTypes::size ||
+      byType.find(typeId<Id<double>>()) != index_of_v<Id<double>, IdTypes>)
+    bench::fail("a typeId lookup went wrong");
+
+  SlotMap<TypedClass<double, SilentPolicy>> objects;
+  ConcurrentHashMap<Id<TypedClass<double, SilentPolicy>>, uint32_t> byId;
+  auto id = objects.insert(1.5);
+  byId.insert(id, 7);
+  objects.erase(id);
+  if (byId.find(id) != 7u || byId.find(objects.insert(2.5)))
+    bench::fail("an Id lookup went wrong");
+
+  constexpr uint64_t kWriters = 4, kPerWriter = 50'000;
+  ConcurrentHashMap<uint64_t, uint64_t> m;
+  std::atomic<uint64_t> done[kWriters] = {};
+  std::vector<std::thread> threads;
+  for (uint64_t w = 0; w < kWriters; ++w)
+    threads.emplace_back([&, w] {
+      for (uint64_t i = 0; i < kPerWriter; ++i) {
+        uint64_t k = keyOf(w * kPerWriter + i);
+        if (!m.insert(k, ~k))
+          bench::fail("a new key was reported as present");
+        done[w].store(i + 1, std::memory_order_release);
+      }
+    });
+  std::atomic<bool> stop{false};
+  for (int r = 0; r < 2; ++r)
+    threads.emplace_back([&, r] {
+      for (uint64_t s = r; !stop.load(std::memory_order_relaxed); ++s) {
+        uint64_t w = s % kWriters;
+        uint64_t upto = done[w].load(std::memory_order_acquire);
+        for (uint64_t i = s % 7; i < upto; i += 997) {
+          uint64_t k = keyOf(w * kPerWriter + i);
+          if (m.find(k) != ~k)
+            bench::fail("a reader missed a key inserted before it looked");
+        }
+      }
+    });
+  for (uint64_t w = 0; w < kWriters; ++w)
+    threads[w].join();
+  stop = true;
+  for (size_t t = kWriters; t < threads.size(); ++t)
+    threads[t].join();
+
+  if (m.size() != kWriters * kPerWriter || m.resizes() == 0)
+    bench::fail("the writers' keys didn't all go in");
+  for (uint64_t i = 0; i < kWriters * kPerWriter; i += 2)
+    if (!m.erase(keyOf(i)))
+      bench::fail("erase missed a key");
+  for (uint64_t i = 0; i < kWriters * kPerWriter; ++i)
+    if (m.find(keyOf(i)) != (i % 2 ? std::optional<uint64_t>(~keyOf(i))
+                                   : std::nullopt))
+      bench::fail("erase removed the wrong keys");
+  if (m.assign(keyOf(1), 7) || m.find(keyOf(1)) != 7u || !m.assign(keyOf(0), 8))
+    bench::fail("assign didn't replace or revive a key");
+}
+
+BENCHMARK_CHECK(checkMap);
+
+constexpr uint64_t kKeys = 1 << 16;
+constexpr int kOpsPerThread = 1 << 14;
+
+struct Striped {
+  ConcurrentHashMap<uint64_t, uint64_t> m{kKeys};
+
+  bool find(uint64_t k) { return m.find(k).has_value(); }
+  void assign(uint64_t k, uint64_t v) { m.assign(k, v); }
+  void erase(uint64_t k) { m.erase(k); }
+};
+
+struct SharedMutex {
+  std::unordered_map<uint64_t, uint64_t> m;
+  std::shared_mutex lock;
+
+  bool find(uint64_t k) {
+    std::shared_lock<std::shared_mutex> guard(lock);
+    return m.find(k) != m.end();
+  }
+  void assign(uint64_t k, uint64_t v) {
+    std::unique_lock<std::shared_mutex> guard(lock);
+    m.insert_or_assign(k, v);
+  }
+  void erase(uint64_t k) {
+    std::unique_lock<std::shared_mutex> guard(lock);
+    m.erase(k);
+  }
+};
+
+static uint64_t xorshift(uint64_t &s) {
+  s ^= s << 13;
+  s ^= s >> 7;
+  s ^= s << 17;
+  return s;
+}
+
+template <class Kind> static void contention(bench::State &state) {
+  Kind map;
+  for (uint64_t i = 0; i < kKeys; ++i)
+    map.assign(keyOf(i), i);
+  int64_t threads = state.range(0);
+  uint64_t writePct = uint64_t(state.range(1));
+  uint64_t found = 0;
+  for (auto _ : state) {
+    std::vector<std::thread> workers;
+    std::atomic<uint64_t> hits{0};
+    for (int64_t t = 0; t < threads; ++t)
+      workers.emplace_back([&, t] {
+        uint64_t s = 88172645463325252ull + uint64_t(t), h = 0;
+        for (int i = 0; i < kOpsPerThread; ++i) {
+          uint64_t r = xorshift(s);
+          uint64_t k = keyOf(r % kKeys);
+          if ((r >> 32) % 100 >= writePct)
+            h += map.find(k);
+          else if (r & (1ull << 20))
+            map.assign(k, r);
+          else
+            map.erase(k);
+        }
+        hits.fetch_add(h, std::memory_order_relaxed);
+      });
+    for (auto &w : workers)
+      w.join();
+    found += hits;
+  }
+  bench::doNotOptimize(found);
+  state.setItemsProcessed(state.iterations() * threads * kOpsPerThread);
+}
+BENCHMARK_TEMPLATE(contention, SharedMutex)
+    ->args({1, 1})->args({4, 1})->args({16, 1})->args({64, 1})
+    ->args({1, 50})->args({4, 50})->args({16, 50})->args({64, 50});
+BENCHMARK_TEMPLATE(contention, Striped)
+    ->args({1, 1})->args({4, 1})->args({16, 1})->args({64, 1})
+    ->args({1, 50})->args({4, 50})->args({16, 50})->args({64, 50});
+
+BENCHMARK_MAIN();
@@ -0,0 +1,151 @@
+// A reader going through the first 4096 elements of an array while another
+// thread appends to it at range(0) elements per millisecond (0: no writer).
+// The array is a ConcurrentDynamicArray read through snapshots, or a
+// DynamicArray behind a std::shared_mutex that the writer takes for each
+// append. grows is how many buffers the writer replaced during the run;
+// the writer stops after kMaxAppends, to bound the memory a long run takes.
+//
+// First checked: a reader racing a writer only ever sees the elements the
+// writer appended, in order; and a retired buffer outlives the snapshots
+// that may see it, and no longer, at the latest once the array is gone.
+
+#include "../concurrentDynamicArray.hpp"
+#include "../dynamicArray.hpp"
+#include "benchHarness.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+static void checkReaders() {
+  {
+    ConcurrentDynamicArray<uint64_t> a;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+      for (uint64_t i = 0; i < (1 << 20); ++i)
+        a.push_back(i);
+      done = true;
+    });
+    size_t last = 0;
+    while (!done) {
+      auto snap = a.read();
+      if (snap.size() < last)
+        bench::fail("a snapshot shrank");
+      for (size_t i = 0; i < snap.size(); i += 97)
+        if (snap[i] != i)
+          bench::fail("a reader saw an element the writer didn't write");
+      last = snap.size();
+    }
+    writer.join();
+  }
+
+  ConcurrentDynamicArray<TypedClass<std::string, SilentPolicy>> a{
+      TypedClass<std::string, SilentPolicy>(std::string(100, 'x'))};
+  epochDomain().collect();
+  size_t before = epochDomain().pending();
+  {
+    auto snap = a.read();
+    auto nested = a.read();
+    for (int i = 0; i < 100; ++i)
+      a.emplace_back(std::string(100, 'y'));
+    a.clear();
+    epochDomain().collect();
+    if (epochDomain().pending() == before)
+      bench::fail("buffers were freed under a snapshot");
+    if (snap.size() != 1 || snap[0].getData() != std::string(100, 'x'))
+      bench::fail("a snapshot changed under its reader");
+  }
+  epochDomain().collect();
+  if (epochDomain().pending() != 0)
+    bench::fail("buffers outlived the snapshots that could see them");
+
+  {
+    ConcurrentDynamicArray<int> b;
+    {
+      auto snap = b.read();
+      for (int i = 0; i < 100; ++i)
+        b.push_back(i);
+    }
+    if (epochDomain().pending() == 0)
+      bench::fail("buffers were freed under a snapshot");
+  }
+  if (epochDomain().pending() != 0)
+    bench::fail("buffers outlived the array they were retired from");
+}
+
+BENCHMARK_CHECK(checkReaders);
+
+constexpr size_t kRead = 4096;
+constexpr int64_t kMaxAppends = int64_t(1) << 25;
+
+struct Epoch {
+  ConcurrentDynamicArray<int> a;
+  size_t grows = 0;
+
+  void append(int x) {
+    size_t cap = a.capacity();
+    a.push_back(x);
+    grows += a.capacity() != cap;
+  }
+  int sum() {
+    auto snap = a.read();
+    int s = 0;
+    for (size_t i = 0; i < kRead; ++i)
+      s += snap[i];
+    return s;
+  }
+};
+
+struct Locked {
+  DynamicArray<int> a;
+  std::shared_mutex lock;
+  size_t grows = 0;
+
+  void append(int x) {
+    std::unique_lock<std::shared_mutex> guard(lock);
+    const int *old = a.data();
+    a.push_back(x);
+    grows += a.data() != old;
+  }
+  int sum() {
+    std::shared_lock<std::shared_mutex> guard(lock);
+    int s = 0;
+    for (size_t i = 0; i < kRead; ++i)
+      s += a[i];
+    return s;
+  }
+};
+
+template <class Kind> static void readWhileAppending(bench::State &state) {
+  Kind k;
+  for (size_t i = 0; i < kRead; ++i)
+    k.append(int(i));
+  k.grows = 0;
+  int64_t perMs = state.range(0);
+  std::atomic<bool> stop{false};
+  std::thread writer([&] {
+    if (perMs == 0)
+      return;
+    auto next = std::chrono::steady_clock::now();
+    for (int64_t n = 0; n < kMaxAppends && !stop.load(std::memory_order_relaxed);
+         n += perMs) {
+      for (int64_t i = 0; i < perMs; ++i)
+        k.append(int(i));
+      next += std::chrono::milliseconds(1);
+      std::this_thread::sleep_until(next);
+    }
+  });
+  for (auto _ : state)
+    bench::doNotOptimize(k.sum());
+  stop = true;
+  writer.join();
+  state.counters["grows"] = double(k.grows);
+  state.setItemsProcessed(state.iterations() * int64_t(kRead));
+}
+BENCHMARK_TEMPLATE(readWhileAppending, Locked)->arg(0)->arg(10)->arg(1000)->arg(100000);
+BENCHMARK_TEMPLATE(readWhileAppending, Epoch)->arg(0)->arg(10)->arg(1000)->arg(100000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,112 @@
+// A representative DynamicArray/TypedClass workload: growing arrays one
+// element at a time, copying them, scanning and sorting them, and building
+// TypedClass elements in place.
+//
+// It doubles as the training run for profile-guided builds (see
+// scripts/pgoBuild.sh), so it should exercise the paths real users hit
+// rather than any one operation in isolation.
+
+#include "../dynamicArray.hpp"
+#include "benchHarness.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+using TypedDouble = TypedClass<double, SilentPolicy>;
+using TypedString = TypedClass<std::string, SilentPolicy>;
+
+// Cheap deterministic pseudo-random values, so every build sees the same data
+static uint64_t next(uint64_t &s) {
+  s ^= s << 13;
+  s ^= s >> 7;
+  s ^= s << 17;
+  return s;
+}
+
+static void pushBackInts(bench::State &state) {
+  for (auto _ : state) {
+    DynamicArray<int> a;
+    for (int64_t i = 0; i < state.range(0); ++i)
+      a.push_back(static_cast<int>(i));
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(pushBackInts)->range(1 << 6, 1 << 18);
+
+static void emplaceTyped(bench::State &state) {
+  for (auto _ : state) {
+    DynamicArray<TypedDouble> a;
+    for (int64_t i = 0; i < state.range(0); ++i)
+      a.emplace_back(double(i) * 0.5);
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(emplaceTyped)->range(1 << 6, 1 << 18);
+
+static void copyTypedStrings(bench::State &state) {
+  DynamicArray<TypedString> a;
+  for (int64_t i = 0; i < state.range(0); ++i)
+    a.emplace_back(std::to_string(i * 7919));
+  for (auto _ : state) {
+    DynamicArray<TypedString> b = a;
+    bench::doNotOptimize(b.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(copyTypedStrings)->range(1 << 6, 1 << 16);
+
+static void scanTyped(bench::State &state) {
+  DynamicArray<TypedDouble> a(state.range(0), TypedDouble(1.5));
+  for (auto _ : state) {
+    double sum = 0;
+    for (const auto &e : a)
+      sum += e.getData();
+    bench::doNotOptimize(sum);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(scanTyped)->range(1 << 6, 1 << 20);
+
+static void sortTyped(bench::State &state) {
+  DynamicArray<TypedDouble> src;
+  uint64_t seed = 88172645463325252ull;
+  for (int64_t i = 0; i < state.range(0); ++i)
+    src.emplace_back(double(next(seed) % 1'000'000));
+  for (auto _ : state) {
+    state.pauseTiming();
+    DynamicArray<TypedDouble> a = src;
+    state.resumeTiming();
+    std::sort(a.begin(), a.end(), [](const auto &x, const auto &y) {
+      return x.getData() < y.getData();
+    });
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(sortTyped)->range(1 << 8, 1 << 16);
+
+// Mixed: the kind of loop a service runs per request
+static void requestLoop(bench::State &state) {
+  uint64_t seed = 2463534242ull;
+  for (auto _ : state) {
+    DynamicArray<TypedDouble> prices;
+    DynamicArray<int> counts;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      uint64_t r = next(seed);
+      prices.emplace_back(double(r % 10'000) / 100.0);
+      if (r & 1)
+        counts.push_back(static_cast<int>(r % 100));
+    }
+    double total = 0;
+    for (size_t i = 0; i < prices.size(); ++i)
+      total += prices[i].getData() * (i < counts.size() ? counts[i] : 1);
+    bench::doNotOptimize(total);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(requestLoop)->range(1 << 6, 1 << 14);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,103 @@
+// Tail latency of a request thread that now and then drops a big array,
+// with the buffer freed in place (DynamicArray) against handed to the
+// reclaimer thread (DeferredDynamicArray). Every kDropEvery-th request
+// builds a range(0)-element array, uses it, and lets it go; the others do
+// a little work on a small one. Each request's latency goes into a
+// histogram, reported as the p50..max counters; the time the big requests
+// spent letting their array go is reported on its own as freeP50 and
+// freeMax. All in ns.
+//
+// The big requests still pay for building their array, in both columns;
+// what moves is the destruction: the element destructors (TypedString) or
+// just the munmap (int). On a single core the reclaimer competes with the
+// request thread for the CPU; once it falls behind, the queue fills and
+// the big requests wait for room (counted in stalls), paying for a free
+// after all.
+//
+// First checked: an array of big arrays, whose destruction on the
+// reclaimer thread defers more buffers than its queue holds, is freed.
+
+#include "../deferredDynamicArray.hpp"
+#include "../hdrHistogram.hpp"
+#include "benchHarness.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+using TypedString = TypedClass<std::string, SilentPolicy>;
+
+// Moving one doesn't throw, assignment included
+static_assert(std::is_nothrow_move_assignable_v<DeferredDynamicArray<int>>);
+static_assert(std::is_nothrow_move_constructible_v<DeferredDynamicArray<int>>);
+
+static void checkNested() {
+  uint64_t before = arrayReclaimer().reclaimed();
+  {
+    DeferredDynamicArray<DeferredDynamicArray<char>> outer(50'000);
+    for (size_t i = 0; i < 100; ++i)
+      outer[i].reserve(size_t(1) << 20);
+  }
+  arrayReclaimer().drain(); // hung here when the inner arrays were queued
+  if (arrayReclaimer().reclaimed() != before + 1)
+    bench::fail("the outer array wasn't reclaimed exactly once");
+}
+
+BENCHMARK_CHECK(checkNested);
+
+constexpr int64_t kDropEvery = 16;
+
+template <class T> static T element() {
+  if constexpr (std::is_same_v<T, TypedString>)
+    return TypedString(std::string(40, 'x')); // past the small-string buffer
+  else
+    return T(1);
+}
+
+static uint64_t nanoseconds(std::chrono::steady_clock::duration d) {
+  return uint64_t(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+}
+
+template <class Array> static void requests(bench::State &state) {
+  using T = std::remove_reference_t<decltype(std::declval<Array &>()[0])>;
+  using Clock = std::chrono::steady_clock;
+  HdrHistogram latency, frees;
+  DynamicArray<int> small(1024, 1);
+  const T value = element<T>();
+  int64_t n = 0;
+  uint64_t stalls = arrayReclaimer().stalls();
+  for (auto _ : state) {
+    auto start = Clock::now();
+    if (++n % kDropEvery == 0) {
+      std::optional<Array> big(std::in_place, size_t(state.range(0)), value);
+      bench::doNotOptimize(big->data());
+      auto freeing = Clock::now();
+      big.reset();
+      frees.record(nanoseconds(Clock::now() - freeing));
+    } else {
+      bench::doNotOptimize(std::accumulate(small.begin(), small.end(), 0));
+    }
+    latency.record(nanoseconds(Clock::now() - start));
+  }
+  arrayReclaimer().drain(); // so the next run starts with an empty queue
+  state.counters["p50"] = double(latency.percentile(50));
+  state.counters["p99"] = double(latency.percentile(99));
+  state.counters["p99.9"] = double(latency.percentile(99.9));
+  state.counters["max"] = double(latency.max());
+  state.counters["freeP50"] = double(frees.percentile(50));
+  state.counters["freeMax"] = double(frees.max());
+  state.counters["stalls"] = double(arrayReclaimer().stalls() - stalls);
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(requests, DynamicArray<int>)->range(1 << 20, 1 << 24);
+BENCHMARK_TEMPLATE(requests, DeferredDynamicArray<int>)->range(1 << 20, 1 << 24);
+BENCHMARK_TEMPLATE(requests, DynamicArray<TypedString>)->range(1 << 16, 1 << 20);
+BENCHMARK_TEMPLATE(requests, DeferredDynamicArray<TypedString>)
+    ->range(1 << 16, 1 << 20);
+
+BENCHMARK_MAIN();
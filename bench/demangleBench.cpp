@@ -0,0 +1,232 @@
+// The in-tree demangler (demangle.hpp) against abi::__cxa_demangle over a
+// corpus of type names and symbols like the ones TypedClass, DynamicArray
+// and the rest of this repo produce. Every name is checked to demangle
+// identically before anything is timed, and demangleSymbols() to give up on
+// a name that would demangle to gigabytes.
+
+#include "../demangle.hpp"
+#include "../dynamicArray.hpp"
+#include "../heteroArray.hpp"
+#include "../moveOnly.hpp"
+#include "../symbolDemangler.hpp"
+#include "benchHarness.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cxxabi.h>
+#include <map>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <vector>
+
+struct Tick;
+
+static const std::vector<const char *> &corpus() {
+  static const std::vector<const char *> names = {
+      // type names, as typeid(T).name() returns them
+      typeid(int).name(),
+      typeid(TypedClass<double>).name(),
+      typeid(TypedClass<std::string, SilentPolicy>).name(),
+      typeid(DynamicArray<TypedClass<double>>).name(),
+      typeid(DynamicArray<DynamicArray<TypedClass<int, SilentPolicy>>>).name(),
+      typeid(HeteroArray<int, double, std::string>).name(),
+      typeid(MoveOnlyDynamicArray<MoveOnlyTypedClass<std::string>>).name(),
+      typeid(std::map<std::string, DynamicArray<TypedClass<double>>>).name(),
+      typeid(void (*)(const DynamicArray<int> &, TypedClass<Tick *> &&)).name(),
+      typeid(int (TypedClass<int>::*)() const).name(),
+      typeid(const char (&)[16]).name(),
+      // symbols, as found in this repo's binaries and libstdc++
+      "_ZNSolsEi",
+      "_ZTIe",
+      "_ZSt17__throw_bad_allocv",
+      "_ZSt13set_terminatePFvvE",
+      "_ZNSdC2EOSd",
+      "_ZTv0_n24_NSoD0Ev",
+      "_ZTVSt5ctypeIwE",
+      "_ZGVNSt8numpunctIcE2idE",
+      "_ZNSt8ios_base7failureB5cxx11D0Ev",
+      "_ZThn16_NSt13basic_fstreamIcSt11char_traitsIcEED0Ev",
+      "_ZZNSt8__detail18__to_chars_10_implImEEvPcjT_E8__digits",
+      "_ZNSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEC2IS3_EEPKcRKS3_"
+      ".constprop.1",
+      "_ZN5bench17registerBenchmarkENSt7__cxx1112basic_stringIcSt11char_"
+      "traitsIcESaIcEEESt8functionIFvRNS_5StateEEE",
+      "_Z4nrvoI10TypedClassISt6vectorIiSaIiEE12SilentPolicyEEvRN5bench5StateE",
+      "_Z10moveReturnI10TypedClassISt6vectorIiSaIiEE12SilentPolicyEEvRN5bench5"
+      "StateE.cold",
+      "_ZNSt6vectorI10TypedClassINSt7__cxx1112basic_stringIcSt11char_traitsIcE"
+      "SaIcEEE15MoveCheckPolicyESaIS8_EED2Ev",
+      "_ZSt16__introsort_loopIN9__gnu_cxx17__normal_iteratorIP10TypedClassId12"
+      "SilentPolicyESt6vectorIS4_SaIS4_EEEElNS0_5__ops15_Iter_comp_iterIZL9"
+      "sortTypedRN5bench5StateEEUlRKT_RKT0_E_EEEvSF_SF_SI_T1_.isra.0",
+      "_ZNSt8_Rb_treeINSt7__cxx1112basic_stringIcSt11char_traitsIcESaIcEEESt4"
+      "pairIKS5_dESt10_Select1stIS8_ESt4lessIS5_ESaIS8_EE22_M_emplace_hint_"
+      "uniqueIJRKSt21piecewise_construct_tSt5tupleIJOS5_EESJ_IJEEEEESt17_Rb_"
+      "tree_iteratorIS8_ESt23_Rb_tree_const_iteratorIS8_EDpOT_",
+      // an empty pack in the middle of a list: "<L, , void>"
+      "_ZNSt6threadC2IZL8checkMapvEUlvE0_JEvEEOT_DpOT0_",
+      "_ZN5clang6interp15ByteCodeEmitter6emitOpIJEEEbNS0_6OpcodeEDpRKT_RKNS0_"
+      "10SourceInfoE",
+      // T_ of a local name's function, brought back by a substitution in the
+      // enclosing function (SC_), and under a reference (RS6_)
+      "_ZSt21__unguarded_partitionIPN4llvm3cfg6UpdateIPNS0_10BasicBlockEEEN9"
+      "__gnu_cxx5__ops15_Iter_comp_iterIZNS1_15LegalizeUpdatesIS4_EEvNS0_8"
+      "ArrayRefINS2_IT_EEEERNS0_15SmallVectorImplISD_EEbbEUlRKS5_SJ_E_EEESC_"
+      "SC_SC_SC_T0_",
+      "_ZZNSt9once_flag18_Prepare_executionC4IZSt9call_onceIRFvvEJEEvRS_OT_"
+      "DpOT0_EUlvE_EERS6_ENUlvE_4_FUNEv",
+      // a default argument's scope, a reference to an array from a pack, and
+      // a function type returning a function pointer
+      "_ZTSZNK5clang15LocationContext9printJsonERN4llvm11raw_ostreamEPKcjbSt8"
+      "functionIFvPKS0_EEEd_UlS8_E_",
+      "_ZN6google8protobuf2io7Printer5PrintIJA2_cA1_cS4_S5_EEEvPKcDpRKT_",
+      "_ZTSSt5_BindIFPFN6google8protobuf4util15status_internal6StatusEPNS2_9"
+      "converter23ProtoStreamObjectWriterENS1_20stringpiece_internal11String"
+      "PieceEES7_St12_PlaceholderILi1EEEE",
+  };
+  return names;
+}
+
+static void checkSame() {
+  char buf[4096];
+  for (const char *name : corpus()) {
+    int status;
+    char *want = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    DemangleResult got = demangle(name, buf, sizeof buf);
+    if (!want || !got || std::strcmp(want, buf) != 0) {
+      std::fprintf(stderr, "%s\n  __cxa_demangle: %s\n  demangle:       %s\n",
+                   name, want ? want : "(failed)", got ? buf : "(failed)");
+      std::abort();
+    }
+    std::free(want);
+  }
+}
+
+BENCHMARK_CHECK(checkSame);
+
+// f(std::pair<int, int>, std::pair<that, that>, ...) with 30 parameters,
+// each one a substitution of the last twice: 30 bytes more of symbol
+// double the output
+static void checkRunaway() {
+  std::string name = "_Z1fSt4pairIiiE";
+  for (char id : std::string_view("0123456789ABCDEFGHIJKLMNOPQRST"))
+    name += std::string("S_IS") + id + "_S" + id + "_E";
+  StringInterner strings;
+  DemangledSymbols out = demangleSymbols({name}, strings, 1);
+  if (out.failed != 1 || out.names[0] != name)
+    bench::fail("a runaway name wasn't counted as failed");
+}
+
+BENCHMARK_CHECK(checkRunaway);
+
+static size_t corpusBytes() {
+  size_t n = 0;
+  for (const char *name : corpus())
+    n += std::strlen(name);
+  return n;
+}
+
+static void demangleInTree(bench::State &state) {
+  Demangler d;
+  char buf[4096];
+  for (auto _ : state)
+    for (const char *name : corpus()) {
+      d.demangle(name, buf, sizeof buf);
+      bench::doNotOptimize(buf);
+    }
+  state.setItemsProcessed(state.iterations() * corpus().size());
+  state.setBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(demangleInTree);
+
+// Through the free function, and so this thread's Demangler
+static void demangleInTreeOneOff(bench::State &state) {
+  char buf[4096];
+  for (auto _ : state)
+    for (const char *name : corpus()) {
+      demangle(name, buf, sizeof buf);
+      bench::doNotOptimize(buf);
+    }
+  state.setItemsProcessed(state.iterations() * corpus().size());
+  state.setBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(demangleInTreeOneOff);
+
+// How TypedClass and checkTypeDem used it: a new buffer every time
+static void cxaDemangle(bench::State &state) {
+  for (auto _ : state)
+    for (const char *name : corpus()) {
+      int status;
+      char *s = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+      bench::doNotOptimize(s);
+      std::free(s);
+    }
+  state.setItemsProcessed(state.iterations() * corpus().size());
+  state.setBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(cxaDemangle);
+
+// __cxa_demangle at its best: one malloc'd buffer, grown as needed
+static void cxaDemangleReusedBuffer(bench::State &state) {
+  size_t len = 4096;
+  char *buf = static_cast<char *>(std::malloc(len));
+  for (auto _ : state)
+    for (const char *name : corpus()) {
+      int status;
+      buf = abi::__cxa_demangle(name, buf, &len, &status);
+      bench::doNotOptimize(buf);
+    }
+  std::free(buf);
+  state.setItemsProcessed(state.iterations() * corpus().size());
+  state.setBytesProcessed(state.iterations() * corpusBytes());
+}
+BENCHMARK(cxaDemangleReusedBuffer);
+
+// range(0) threads each demangling the corpus kPasses times per iteration
+constexpr int kPasses = 32;
+
+static void demangleInTreeThreads(bench::State &state) {
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int64_t t = 0; t < state.range(0); ++t)
+      threads.emplace_back([] {
+        Demangler d;
+        char buf[4096];
+        for (int p = 0; p < kPasses; ++p)
+          for (const char *name : corpus()) {
+            d.demangle(name, buf, sizeof buf);
+            bench::doNotOptimize(buf);
+          }
+      });
+    for (auto &t : threads)
+      t.join();
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0) * kPasses *
+                          corpus().size());
+}
+BENCHMARK(demangleInTreeThreads)->rangeMultiplier(2)->range(1, 8);
+
+static void cxaDemangleThreads(bench::State &state) {
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int64_t t = 0; t < state.range(0); ++t)
+      threads.emplace_back([] {
+        for (int p = 0; p < kPasses; ++p)
+          for (const char *name : corpus()) {
+            int status;
+            char *s = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+            bench::doNotOptimize(s);
+            std::free(s);
+          }
+      });
+    for (auto &t : threads)
+      t.join();
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0) * kPasses *
+                          corpus().size());
+}
+BENCHMARK(cxaDemangleThreads)->rangeMultiplier(2)->range(1, 8);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,157 @@
+// The generic, field-enumeration based serializer and hasher from
+// fieldReflection.hpp versus the code one would write by hand for the same
+// payload. Both produce byte-identical output (checked before timing), so the
+// difference is purely what the compiler makes of the generic version.
+//
+// deserialize() is first checked to undo serialize(), and to reject
+// truncated input, string lengths past the end and trailing bytes.
+
+#include "../fieldReflection.hpp"
+#include "benchHarness.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+struct Tick {
+  int64_t ts;
+  double price;
+  int32_t qty;
+  char side;
+};
+static_assert(field_count_v<Tick> == 4);
+
+using Row = TypedClass<Tick, SilentPolicy>;
+
+static DynamicArray<Row> makeRows(int64_t n) {
+  DynamicArray<Row> rows;
+  rows.reserve(n);
+  for (int64_t i = 0; i < n; ++i)
+    rows.push_back(Row(Tick{i, 100.0 + double(i % 97) * 0.25,
+                            int32_t(i % 1000), i % 2 ? 'B' : 'S'}));
+  return rows;
+}
+
+// What we used to write for every payload type
+template <class Sink> static void encodeByHand(Sink &out, const DynamicArray<Row> &rows) {
+  uint64_t n = rows.size();
+  out.write(&n, sizeof n);
+  for (const auto &r : rows) {
+    Tick t = r.getData();
+    out.write(&t.ts, sizeof t.ts);
+    out.write(&t.price, sizeof t.price);
+    out.write(&t.qty, sizeof t.qty);
+    out.write(&t.side, sizeof t.side);
+  }
+}
+
+static void checkSame(const DynamicArray<Row> &rows) {
+  ByteWriter hand;
+  encodeByHand(hand, rows);
+  Fnv1aHasher handHash;
+  encodeByHand(handHash, rows);
+  if (hand.bytes != serialize(rows) || handHash.h != hashValue(rows))
+    bench::fail("generic and hand-written encodings differ");
+}
+
+template <class T> static bool rejects(const std::vector<unsigned char> &bytes) {
+  try {
+    deserialize<T>(bytes);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+static void checkRoundTrip() {
+  auto rows = makeRows(1000);
+  auto bytes = serialize(rows);
+  if (serialize(deserialize<DynamicArray<Row>>(bytes)) != bytes)
+    bench::fail("deserialize doesn't undo serialize");
+  std::string str = "a string with a length prefix";
+  if (deserialize<std::string>(serialize(str)) != str)
+    bench::fail("deserialize doesn't undo serialize for a string");
+
+  auto cut = bytes;
+  cut.pop_back();
+  auto extra = bytes;
+  extra.push_back(0);
+  // A length of 2^62 and no characters behind it
+  auto huge = serialize(uint64_t(1) << 62);
+  if (!rejects<DynamicArray<Row>>(cut) || !rejects<DynamicArray<Row>>(extra) ||
+      !rejects<std::string>(huge) || !rejects<bool>({2}))
+    bench::fail("deserialize accepted malformed input");
+
+  enum class Side : char { Buy = 'B', Sell = 'S' };
+  if (!deserialize<bool>({1}) || deserialize<bool>(serialize(false)) ||
+      deserialize<Side>(serialize(Side::Sell)) != Side::Sell)
+    bench::fail("deserialize doesn't undo serialize for a bool or an enum");
+}
+
+BENCHMARK_CHECK(checkRoundTrip);
+
+static void serializeGeneric(bench::State &state) {
+  auto rows = makeRows(state.range(0));
+  checkSame(rows);
+  for (auto _ : state) {
+    ByteWriter w;
+    w.bytes.reserve(8 + rows.size() * 21);
+    encode(w, rows);
+    bench::doNotOptimize(w.bytes.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(serializeGeneric)->range(1 << 8, 1 << 20);
+
+static void serializeByHand(bench::State &state) {
+  auto rows = makeRows(state.range(0));
+  for (auto _ : state) {
+    ByteWriter w;
+    w.bytes.reserve(8 + rows.size() * 21);
+    encodeByHand(w, rows);
+    bench::doNotOptimize(w.bytes.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(serializeByHand)->range(1 << 8, 1 << 20);
+
+static void hashGeneric(bench::State &state) {
+  auto rows = makeRows(state.range(0));
+  for (auto _ : state)
+    bench::doNotOptimize(hashValue(rows));
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(hashGeneric)->range(1 << 8, 1 << 20);
+
+static void hashByHand(bench::State &state) {
+  auto rows = makeRows(state.range(0));
+  for (auto _ : state) {
+    Fnv1aHasher h;
+    encodeByHand(h, rows);
+    bench::doNotOptimize(h.h);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(hashByHand)->range(1 << 8, 1 << 20);
+
+static void deserializeGeneric(bench::State &state) {
+  auto bytes = serialize(makeRows(state.range(0)));
+  for (auto _ : state) {
+    auto rows = deserialize<DynamicArray<Row>>(bytes);
+    bench::doNotOptimize(rows.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(deserializeGeneric)->range(1 << 8, 1 << 20);
+
+static void toSoAGeneric(bench::State &state) {
+  auto rows = makeRows(state.range(0));
+  for (auto _ : state) {
+    auto cols = toSoA(rows);
+    bench::doNotOptimize(std::get<0>(cols).data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(toSoAGeneric)->range(1 << 8, 1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+// HeteroArray<int, double> (one contiguous bucket per type) versus
+// DynamicArray<std::variant<int, double>> (one tagged slot per element).
+//
+// Both hold the same values, half ints and half doubles in alternating
+// insertion order, and both sum all of them. The variant side branches on
+// the tag for every element; the HeteroArray side runs two straight loops.
+
+#include "../heteroArray.hpp"
+#include "benchHarness.hpp"
+
+#include <cstdint>
+#include <type_traits>
+#include <variant>
+
+using Variant = std::variant<int, double>;
+
+static void fill(HeteroArray<int, double> &h, int64_t n) {
+  h.reserve<int>(n / 2 + 1);
+  h.reserve<double>(n / 2 + 1);
+  for (int64_t i = 0; i < n; ++i)
+    if (i % 2 == 0)
+      h.push_back(static_cast<int>(i));
+    else
+      h.push_back(static_cast<double>(i) * 0.5);
+}
+
+static void fill(DynamicArray<Variant> &v, int64_t n) {
+  v.reserve(n);
+  for (int64_t i = 0; i < n; ++i)
+    if (i % 2 == 0)
+      v.push_back(Variant{static_cast<int>(i)});
+    else
+      v.push_back(Variant{static_cast<double>(i) * 0.5});
+}
+
+static void variantVisit(bench::State &state) {
+  DynamicArray<Variant> v;
+  fill(v, state.range(0));
+  for (auto _ : state) {
+    double sum = 0;
+    for (const auto &x : v)
+      sum += std::visit([](auto y) { return static_cast<double>(y); }, x);
+    bench::doNotOptimize(sum);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes/elem"] = double(sizeof(Variant));
+}
+BENCHMARK(variantVisit)->range(1 << 10, 1 << 22);
+
+static void heteroForEach(bench::State &state) {
+  HeteroArray<int, double> h;
+  fill(h, state.range(0));
+  for (auto _ : state) {
+    // Separate accumulators per type keep the int loop in integer registers
+    int64_t isum = 0;
+    double dsum = 0;
+    h.forEach([&](auto y) {
+      if constexpr (std::is_same_v<decltype(y), int>)
+        isum += y;
+      else
+        dsum += y;
+    });
+    bench::doNotOptimize(isum);
+    bench::doNotOptimize(dsum);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes/elem"] =
+      double(h.count<int>() * sizeof(int) + h.count<double>() * sizeof(double)) /
+      double(h.size());
+}
+BENCHMARK(heteroForEach)->range(1 << 10, 1 << 22);
+
+static void heteroVisitBuckets(bench::State &state) {
+  HeteroArray<int, double> h;
+  fill(h, state.range(0));
+  for (auto _ : state) {
+    double sum = 0;
+    h.visitBuckets([&](const auto &b) {
+      using T = std::remove_cvref_t<decltype(b[0])>;
+      std::conditional_t<std::is_integral_v<T>, int64_t, T> part{};
+      for (size_t i = 0; i < b.size(); ++i)
+        part += b[i];
+      sum += static_cast<double>(part);
+    });
+    bench::doNotOptimize(sum);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(heteroVisitBuckets)->range(1 << 10, 1 << 22);
+
+BENCHMARK_MAIN();
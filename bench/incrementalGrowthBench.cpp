@@ -0,0 +1,93 @@
+// The longest a single push_back takes while an array grows to range(0)
+// elements: DynamicArray, which moves everything on each reallocation,
+// against IncrementalDynamicArray, which moves kStep elements per
+// insertion, and the same with its old buffers freed by arrayReclaimer().
+// Every push_back is timed into a histogram; the max counter is the
+// longest pause, in ns. The clock reads are part of the per-item time.
+//
+// IncrementalDynamicArray is checked against std::vector first.
+
+#include "../incrementalDynamicArray.hpp"
+#include "../hdrHistogram.hpp"
+#include "benchHarness.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Indexing mid-growth, pushing an element of the array itself (also when
+// the push has to finish a growth first), reserve() with too little room
+// to finish the move in, copies, and iteration
+static void checkAgainstVector() {
+  IncrementalDynamicArray<std::string> a;
+  std::vector<std::string> v;
+  for (int i = 0; i < 100'000; ++i) {
+    if (i % 1000 == 999) {
+      a.push_back(a[size_t(i) / 2]);
+      v.push_back(v[size_t(i) / 2]);
+    } else {
+      a.push_back(std::to_string(i));
+      v.push_back(std::to_string(i));
+    }
+    if (i == 50'000)
+      a.reserve(a.size() + 1);
+    if (a[size_t(i) / 3] != v[size_t(i) / 3] || a.back() != v.back())
+      bench::fail("an element differs from std::vector's");
+  }
+  IncrementalDynamicArray<std::string> b = a;
+  a.finishGrowth();
+  size_t i = 0;
+  for (const std::string &s : b)
+    if (s != v[i++] || a[i - 1] != s)
+      bench::fail("a copy or iteration differs");
+  if (i != v.size() || a.growing())
+    bench::fail("wrong size, or still growing after finishGrowth()");
+
+  // Pushing an element still in the old buffer, when the push has to
+  // finish that growth first
+  IncrementalDynamicArray<std::string> c;
+  for (int j = 0; j < 128; ++j)
+    c.push_back(std::string(64, char('a' + j % 26)));
+  c.reserve(138);
+  for (int j = 0; j < 10; ++j)
+    c.push_back(std::string(64, 'z'));
+  if (!c.growing() || c.size() != c.capacity())
+    bench::fail("the array isn't full mid-growth");
+  c.push_back(c[50]);
+  if (c.back() != std::string(64, char('a' + 50 % 26)) || c[50] != c.back())
+    bench::fail("pushing an element of the array itself mid-growth went wrong");
+}
+
+BENCHMARK_CHECK(checkAgainstVector);
+
+template <class Array> static void pushBackPauses(bench::State &state) {
+  using Clock = std::chrono::steady_clock;
+  HdrHistogram pauses;
+  for (auto _ : state) {
+    Array a;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      auto start = Clock::now();
+      a.push_back(static_cast<int>(i));
+      pauses.record(uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 Clock::now() - start)
+                                 .count()));
+    }
+    bench::doNotOptimize(&a[0]);
+  }
+  arrayReclaimer().drain();
+  state.counters["p99.99"] = double(pauses.percentile(99.99));
+  state.counters["max"] = double(pauses.max());
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(pushBackPauses, DynamicArray<int>)
+    ->rangeMultiplier(100)
+    ->range(1'000'000, 100'000'000);
+BENCHMARK_TEMPLATE(pushBackPauses, IncrementalDynamicArray<int>)
+    ->rangeMultiplier(100)
+    ->range(1'000'000, 100'000'000);
+BENCHMARK_TEMPLATE(pushBackPauses, IncrementalDynamicArray<int, true>)
+    ->rangeMultiplier(100)
+    ->range(1'000'000, 100'000'000);
+
+BENCHMARK_MAIN();
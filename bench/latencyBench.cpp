@@ -0,0 +1,159 @@
+// What per-operation latency recording costs: HdrHistogram::record alone,
+// LatencyMetrics::record with its per-thread lookup, the clock reads, and
+// DynamicArray against TimedDynamicArray on the operations the latter
+// times. The histograms are checked against exact percentiles first, and
+// LatencyMetrics for keeping apart the values of one that reuses the id of
+// an earlier one. The latencies TimedDynamicArray collected are printed at
+// exit.
+
+#include "../hdrHistogram.hpp"
+#include "../timedDynamicArray.hpp"
+#include "benchHarness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using TypedDouble = TypedClass<double, SilentPolicy>;
+
+// Every percentile has to be within one bucket (1/64) above the exact one
+static void checkPercentiles() {
+  HdrHistogram h;
+  std::vector<uint64_t> values;
+  uint64_t s = 88172645463325252ull;
+  for (int i = 0; i < 100'000; ++i) {
+    s ^= s << 13;
+    s ^= s >> 7;
+    s ^= s << 17;
+    values.push_back(s % (uint64_t(1) << (i % 36)));
+    h.record(values.back());
+  }
+  std::sort(values.begin(), values.end());
+  for (double p : {0.1, 1.0, 25.0, 50.0, 90.0, 99.0, 99.9, 99.99, 100.0}) {
+    uint64_t exact = values[size_t(std::ceil(p / 100 * values.size())) - 1];
+    uint64_t got = h.percentile(p);
+    if (got < exact || got > exact + exact / 64) {
+      std::fprintf(stderr, "p%g: exact %llu, histogram %llu\n", p,
+                   (unsigned long long)exact, (unsigned long long)got);
+      std::abort();
+    }
+  }
+}
+
+// A LatencyMetrics made where another one was, and likely given its id,
+// starts out empty on a thread that recorded into the old one
+static void checkFreshMetrics() {
+  for (uint64_t round = 1; round <= 3; ++round) {
+    LatencyMetrics m({"op"});
+    if (m.snapshot(0).count() != 0)
+      bench::fail("a new LatencyMetrics saw an earlier one's values");
+    m.record(0, round);
+    std::thread([&] { m.record(0, round); }).join();
+    if (m.snapshot(0).count() != 2 || m.snapshot(0).max() != round)
+      bench::fail("LatencyMetrics lost or mixed up values");
+  }
+}
+
+BENCHMARK_CHECK(checkFreshMetrics);
+
+[[maybe_unused]] static const bool checked = [] {
+  checkPercentiles();
+  arrayLatencies(); // constructed before the handler, so it outlives it
+  std::atexit([] {
+    std::cout << "\nTimedDynamicArray latencies (ns):\n";
+    arrayLatencies().dump(std::cout);
+  });
+  return true;
+}();
+
+static void clockNow(bench::State &state) {
+  for (auto _ : state)
+    bench::doNotOptimize(std::chrono::steady_clock::now());
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(clockNow);
+
+static void histogramRecord(bench::State &state) {
+  HdrHistogram h;
+  uint64_t v = 1;
+  for (auto _ : state) {
+    h.record(v);
+    v = v * 3 % 1'000'003;
+  }
+  bench::doNotOptimize(h);
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(histogramRecord);
+
+static void metricsRecord(bench::State &state) {
+  LatencyMetrics m({"op"});
+  uint64_t v = 1;
+  for (auto _ : state) {
+    m.record(0, v);
+    v = v * 3 % 1'000'003;
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK(metricsRecord);
+
+// range(0) threads recording into the same LatencyMetrics at once
+static void metricsRecordThreads(bench::State &state) {
+  constexpr int kPerThread = 1 << 16;
+  LatencyMetrics m({"op"});
+  for (auto _ : state) {
+    std::vector<std::thread> threads;
+    for (int64_t t = 0; t < state.range(0); ++t)
+      threads.emplace_back([&m] {
+        for (int i = 0; i < kPerThread; ++i)
+          m.record(0, uint64_t(i));
+      });
+    for (auto &t : threads)
+      t.join();
+  }
+  if (m.snapshot(0).count() != uint64_t(state.iterations() * state.range(0) *
+                                         kPerThread))
+    std::abort(); // a thread's values went missing in the merge
+  state.setItemsProcessed(state.iterations() * state.range(0) * kPerThread);
+}
+BENCHMARK(metricsRecordThreads)->rangeMultiplier(2)->range(1, 8);
+
+template <class Array> static void construct(bench::State &state) {
+  for (auto _ : state) {
+    Array a(state.range(0), TypedDouble(1.0));
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(construct, DynamicArray<TypedDouble>)->range(8, 1 << 12);
+BENCHMARK_TEMPLATE(construct, TimedDynamicArray<TypedDouble>)->range(8, 1 << 12);
+
+template <class Array> static void pushBack(bench::State &state) {
+  for (auto _ : state) {
+    Array a;
+    for (int64_t i = 0; i < state.range(0); ++i)
+      a.push_back(static_cast<int>(i));
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(pushBack, DynamicArray<int>)->range(8, 1 << 16);
+BENCHMARK_TEMPLATE(pushBack, TimedDynamicArray<int>)->range(8, 1 << 16);
+
+template <class Array> static void copy(bench::State &state) {
+  Array src(state.range(0), TypedDouble(2.0));
+  for (auto _ : state) {
+    Array a = src;
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(copy, DynamicArray<TypedDouble>)->range(8, 1 << 12);
+BENCHMARK_TEMPLATE(copy, TimedDynamicArray<TypedDouble>)->range(8, 1 << 12);
+
+BENCHMARK_MAIN();
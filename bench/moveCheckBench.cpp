@@ -0,0 +1,50 @@
+// Cost of MoveCheckPolicy on a DynamicArray<TypedClass<std::string>>
+// workload, against SilentPolicy doing the same work.
+//
+// Built with NDEBUG (a release build) the two must be indistinguishable,
+// and the static_assert below checks they are even the same size. Built
+// without NDEBUG this shows what the checking costs.
+
+#include "../dynamicArray.hpp"
+#include "../moveCheckPolicy.hpp"
+#include "benchHarness.hpp"
+
+#include <string>
+#include <utility>
+
+#ifdef NDEBUG
+static_assert(sizeof(TypedClass<std::string, MoveCheckPolicy>) ==
+              sizeof(TypedClass<std::string, SilentPolicy>));
+#endif
+
+// Builds n strings, rotates them through a second array by moving, then
+// copies it and reads every element
+template <class Policy> static void workload(bench::State &state) {
+  using Elem = TypedClass<std::string, Policy>;
+  const size_t n = state.range(0);
+  for (auto _ : state) {
+    DynamicArray<Elem> a;
+    a.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+      a.emplace_back(std::string(24, char('a' + i % 26)));
+
+    DynamicArray<Elem> b;
+    b.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+      b.push_back(std::move(a[(i + 1) % n]));
+    for (size_t i = 0; i < n; ++i)
+      a[i] = std::move(b[i]);
+
+    DynamicArray<Elem> c = a;
+    size_t total = 0;
+    for (const auto &e : c)
+      total += e.getData().size();
+    bench::doNotOptimize(total);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+  state.counters["bytes/elem"] = double(sizeof(Elem));
+}
+BENCHMARK_TEMPLATE(workload, SilentPolicy)->range(64, 1 << 16);
+BENCHMARK_TEMPLATE(workload, MoveCheckPolicy)->range(64, 1 << 16);
+
+BENCHMARK_MAIN();
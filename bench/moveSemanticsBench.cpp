@@ -0,0 +1,129 @@
+// Measured numbers for the claims made in valueCategories.cpp.
+//
+// For std::vector<int>, std::string, DynamicArray<int> and
+// TypedClass<std::vector<int>> of 1 to 10^7 elements this times:
+//   copy        T b(a);
+//   move        T b(std::move(a)); a = std::move(b);  (a move there and back)
+//   rvo         return T(...);             a prvalue: the copy is elided
+//   nrvo        T r(...); return r;        a named local: elided in practice
+//   moveReturn  T r(...); return std::move(r);  forces a move, defeats NRVO
+// and reports the heap allocations each iteration performs (link with
+// allocTracker.cpp for those to be non-zero).
+//
+// The three factories include building the object, so only their difference
+// from one another is interesting, not their absolute value.
+
+#include "../allocTracker.hpp"
+#include "../dynamicArray.hpp"
+#include "../typedClass.hpp"
+#include "benchHarness.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// How to build a T holding n elements
+template <class T> struct Make;
+template <> struct Make<std::vector<int>> {
+  static std::vector<int> of(size_t n) { return std::vector<int>(n, 1); }
+};
+template <> struct Make<std::string> {
+  static std::string of(size_t n) { return std::string(n, 'x'); }
+};
+template <> struct Make<DynamicArray<int>> {
+  static DynamicArray<int> of(size_t n) { return DynamicArray<int>(n, 1); }
+};
+using Typed = TypedClass<std::vector<int>, SilentPolicy>;
+template <> struct Make<Typed> {
+  static Typed of(size_t n) { return Typed(std::vector<int>(n, 1)); }
+};
+
+template <class T> [[gnu::noinline]] T makeRvo(size_t n) { return Make<T>::of(n); }
+
+template <class T> [[gnu::noinline]] T makeNrvo(size_t n) {
+  T r = Make<T>::of(n);
+  bench::doNotOptimize(r);
+  return r;
+}
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpessimizing-move"
+template <class T> [[gnu::noinline]] T makeMoveReturn(size_t n) {
+  T r = Make<T>::of(n);
+  bench::doNotOptimize(r);
+  return std::move(r);
+}
+#pragma GCC diagnostic pop
+
+static void reportAllocations(bench::State &state, const AllocScope &scope) {
+  // Read before touching state.counters, which allocates map nodes itself
+  AllocCounts c = scope.counts();
+  state.counters["allocs/op"] =
+      bench::Counter(double(c.allocations), bench::Counter::AvgIterations);
+  state.counters["bytes/op"] =
+      bench::Counter(double(c.bytes), bench::Counter::AvgIterations);
+}
+
+template <class T> static void copy(bench::State &state) {
+  T a = Make<T>::of(state.range(0));
+  AllocScope scope;
+  for (auto _ : state) {
+    T b(a);
+    bench::doNotOptimize(b);
+  }
+  reportAllocations(state, scope);
+}
+
+template <class T> static void move(bench::State &state) {
+  T a = Make<T>::of(state.range(0));
+  AllocScope scope;
+  for (auto _ : state) {
+    T b(std::move(a));
+    bench::doNotOptimize(b);
+    a = std::move(b);
+  }
+  reportAllocations(state, scope);
+}
+
+template <class T> static void rvo(bench::State &state) {
+  AllocScope scope;
+  for (auto _ : state) {
+    T b = makeRvo<T>(state.range(0));
+    bench::doNotOptimize(b);
+  }
+  reportAllocations(state, scope);
+}
+
+template <class T> static void nrvo(bench::State &state) {
+  AllocScope scope;
+  for (auto _ : state) {
+    T b = makeNrvo<T>(state.range(0));
+    bench::doNotOptimize(b);
+  }
+  reportAllocations(state, scope);
+}
+
+template <class T> static void moveReturn(bench::State &state) {
+  AllocScope scope;
+  for (auto _ : state) {
+    T b = makeMoveReturn<T>(state.range(0));
+    bench::doNotOptimize(b);
+  }
+  reportAllocations(state, scope);
+}
+
+#define MOVE_SEMANTICS_BENCHMARKS(T)                                           \
+  BENCHMARK_TEMPLATE(copy, T)->rangeMultiplier(10)->range(1, 10'000'000);      \
+  BENCHMARK_TEMPLATE(move, T)->rangeMultiplier(10)->range(1, 10'000'000);      \
+  BENCHMARK_TEMPLATE(rvo, T)->rangeMultiplier(10)->range(1, 10'000'000);       \
+  BENCHMARK_TEMPLATE(nrvo, T)->rangeMultiplier(10)->range(1, 10'000'000);      \
+  BENCHMARK_TEMPLATE(moveReturn, T)->rangeMultiplier(10)->range(1, 10'000'000)
+
+using IntVector = std::vector<int>;
+using IntArray = DynamicArray<int>;
+MOVE_SEMANTICS_BENCHMARKS(IntVector);
+MOVE_SEMANTICS_BENCHMARKS(std::string);
+MOVE_SEMANTICS_BENCHMARKS(IntArray);
+MOVE_SEMANTICS_BENCHMARKS(Typed);
+
+BENCHMARK_MAIN();
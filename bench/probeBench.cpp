@@ -0,0 +1,119 @@
+// What the typedclass:* and dynamicarray:* probes cost while nothing is
+// attached to them, which is supposed to be nothing measurable.
+//
+// This file is built twice: probeBench with the probes compiled in and
+// probeBenchNoProbes with INTERESTING_NO_PROBES. Run both and compare
+// like-named rows; they should agree within run-to-run noise. The
+// bareLoop/probeLoop pair isolates a single probe in a tight loop.
+//
+// A probe inside a loop the compiler would otherwise vectorize would show:
+// that's why DynamicArray relocates TypedClass elements on growth through
+// a constructor without one, and emplaceTyped relocates its elements the
+// same way in both builds.
+
+#include "../dynamicArray.hpp"
+#include "../probes.hpp"
+#include "benchHarness.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+using TypedDouble = TypedClass<double, SilentPolicy>;
+using TypedString = TypedClass<std::string, SilentPolicy>;
+
+[[maybe_unused]] static const bool announced = [] {
+  std::fprintf(stderr, "note: probes %s\n",
+               TRACE_PROBES_ENABLED ? "compiled in" : "compiled out");
+  return true;
+}();
+
+// Relocating on growth keeps the elements, including when the one being
+// inserted is itself an element
+static void checkRelocation() {
+  DynamicArray<TypedString> a;
+  a.emplace_back(std::string(32, 'x'));
+  for (int i = 0; i < 40; ++i) {
+    if (i % 2)
+      a.push_back(a[0]);
+    else
+      a.emplace_back(a[a.size() - 1]);
+  }
+  for (const TypedString &s : a)
+    if (s.getData() != std::string(32, 'x'))
+      bench::fail("an element was lost relocating on growth");
+}
+BENCHMARK_CHECK(checkRelocation);
+
+static void bareLoop(bench::State &state) {
+  for (auto _ : state)
+    for (int64_t i = 0; i < state.range(0); ++i)
+      bench::doNotOptimize(i);
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bareLoop)->range(1 << 10, 1 << 10);
+
+static void probeLoop(bench::State &state) {
+  for (auto _ : state)
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      TRACE_PROBE(bench, loop, i, &state);
+      bench::doNotOptimize(i);
+    }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(probeLoop)->range(1 << 10, 1 << 10);
+
+// dynamicarray:grow on every reallocation, alloc/free per array
+static void pushBackInts(bench::State &state) {
+  for (auto _ : state) {
+    DynamicArray<int> a;
+    for (int64_t i = 0; i < state.range(0); ++i)
+      a.push_back(static_cast<int>(i));
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(pushBackInts)->range(1 << 6, 1 << 16);
+
+// typedclass:construct per element; relocating on growth fires nothing per
+// element (see TypedClass's Relocation constructor)
+static void emplaceTyped(bench::State &state) {
+  for (auto _ : state) {
+    DynamicArray<TypedDouble> a;
+    for (int64_t i = 0; i < state.range(0); ++i)
+      a.emplace_back(double(i));
+    bench::doNotOptimize(a.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(emplaceTyped)->range(1 << 6, 1 << 16);
+
+// dynamicarray:alloc, typedclass:copy per element, then :destroy per element
+static void copyTypedStrings(bench::State &state) {
+  DynamicArray<TypedString> a;
+  for (int64_t i = 0; i < state.range(0); ++i)
+    a.emplace_back(std::to_string(i));
+  for (auto _ : state) {
+    DynamicArray<TypedString> b = a;
+    bench::doNotOptimize(b.data());
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(copyTypedStrings)->range(1 << 6, 1 << 14);
+
+// Probes on objects that live only in registers
+static void typedTemporaries(bench::State &state) {
+  for (auto _ : state) {
+    double sum = 0;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+      TypedDouble t(static_cast<double>(i));
+      TypedDouble u = t;
+      sum += u.getData();
+    }
+    bench::doNotOptimize(sum);
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(typedTemporaries)->range(1 << 10, 1 << 10);
+
+BENCHMARK_MAIN();
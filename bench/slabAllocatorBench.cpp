@@ -0,0 +1,218 @@
+// Individually allocated TypedClass objects: new/delete (through
+// std::unique_ptr) against slabAllocator.hpp's PoolPtr, with and without
+// its per-thread caches. Throughput for alloc/free pairs, for a pool of
+// live objects replaced in random order, and for several threads at once;
+// then memory: after a churn that frees a random 3/4 of the objects and
+// allocates again, heapBytes/live is what the allocator holds per live
+// object (malloc's whole heap; the slabs of the pool) and usedBytes/live
+// what the live objects take up of it, headers and rounding included.
+//
+// malloc's heap is shared with everything else in the process and never
+// shrinks much, so compare fragmentation rows from separate runs:
+//   slabAllocatorBench --filter='fragmentation<NewDelete'   (and Slab)
+//
+// The allocator's bookkeeping is checked first: slots are reused, and
+// outstanding() comes back down when objects are freed, including on
+// another thread, at thread exit and when a constructor throws.
+
+#include "../slabAllocator.hpp"
+#include "../typedClass.hpp"
+#include "benchHarness.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <malloc.h>
+
+using TypedDouble = TypedClass<double, SilentPolicy>;
+using TypedString = TypedClass<std::string, SilentPolicy>;
+using TypedVec3 = TypedClass<std::array<double, 3>, SilentPolicy>;
+
+// Types of their own, so the checks leave the benchmarks' allocators alone
+struct Counted {
+  static inline std::atomic<int> live{0};
+  int v;
+  explicit Counted(int v) : v(v) { ++live; }
+  ~Counted() { --live; }
+};
+struct Throws {
+  explicit Throws(bool fail) {
+    if (fail)
+      throw 1;
+  }
+};
+
+static void checkAllocator() {
+  auto &shared = slabAllocator<Counted, false>();
+  size_t start = shared.outstanding();
+  void *first;
+  {
+    auto p = makePooled<Counted, false>(1);
+    first = p.get();
+    if (shared.outstanding() != start + 1)
+      bench::fail("outstanding() didn't count a live object");
+  }
+  if (shared.outstanding() != start)
+    bench::fail("outstanding() didn't come back down after a free");
+  if (makePooled<Counted, false>(2).get() != first)
+    bench::fail("a freed slot wasn't reused");
+
+  // The slot goes back when the constructor throws
+  auto &throwing = slabAllocator<Throws, false>();
+  size_t before = throwing.outstanding();
+  void *slot = makePooled<Throws, false>(false).get();
+  try {
+    makePooled<Throws, false>(true);
+    bench::fail("the constructor didn't throw");
+  } catch (int) {
+  }
+  if (throwing.outstanding() != before)
+    bench::fail("makePooled kept the slot of a constructor that threw");
+  if (makePooled<Throws, false>(false).get() != slot)
+    bench::fail("makePooled didn't free the slot of a constructor that threw");
+
+  // Objects made on one thread and freed on another; both threads' caches
+  // go back to the shared list when they exit
+  auto &cached = slabAllocator<Counted>();
+  start = cached.outstanding();
+  std::thread([&] {
+    auto p = makePooled<Counted>(3);
+    std::thread([&] { p.reset(); }).join();
+    if (p || Counted::live != 0)
+      bench::fail("a PoolPtr reset on another thread wasn't destroyed");
+    auto q = makePooled<Counted>(4);
+    if (cached.outstanding() == start)
+      bench::fail("outstanding() didn't count the thread's cache");
+  }).join();
+  if (Counted::live != 0)
+    bench::fail("an object outlived its PoolPtr");
+  if (cached.outstanding() != start)
+    bench::fail("a thread's cache wasn't spilled when it exited");
+}
+BENCHMARK_CHECK(checkAllocator);
+
+struct NewDelete {
+  template <class T, class... Args> static auto make(Args &&...args) {
+    return std::make_unique<T>(std::forward<Args>(args)...);
+  }
+  template <class T> static size_t heldBytes() {
+    struct mallinfo2 m = mallinfo2();
+    return m.arena + m.hblkhd;
+  }
+  template <class T> static size_t usedBytes() { return mallinfo2().uordblks; }
+};
+
+template <bool Cached> struct Slab {
+  template <class T, class... Args> static auto make(Args &&...args) {
+    return makePooled<T, Cached>(std::forward<Args>(args)...);
+  }
+  template <class T> static size_t heldBytes() {
+    return slabAllocator<T, Cached>().reservedBytes();
+  }
+  template <class T> static size_t usedBytes() {
+    return slabAllocator<T, Cached>().outstanding() *
+           SlabAllocator<T, Cached>::kSlot;
+  }
+};
+
+template <class T> static T value(uint64_t i) {
+  if constexpr (std::is_same_v<T, TypedString>)
+    return T(std::to_string(i));
+  else if constexpr (std::is_same_v<T, TypedVec3>)
+    return T({double(i), 0.0, 0.0});
+  else
+    return T(double(i));
+}
+
+static uint64_t xorshift(uint64_t &s) {
+  s ^= s << 13;
+  s ^= s >> 7;
+  s ^= s << 17;
+  return s;
+}
+
+template <class Kind, class T> static void allocFree(bench::State &state) {
+  uint64_t i = 0;
+  for (auto _ : state) {
+    auto p = Kind::template make<T>(value<T>(i++));
+    bench::doNotOptimize(p.get());
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(allocFree, NewDelete, TypedDouble);
+BENCHMARK_TEMPLATE(allocFree, Slab<false>, TypedDouble);
+BENCHMARK_TEMPLATE(allocFree, Slab<true>, TypedDouble);
+BENCHMARK_TEMPLATE(allocFree, NewDelete, TypedString);
+BENCHMARK_TEMPLATE(allocFree, Slab<true>, TypedString);
+
+// range(0) live objects, a random one replaced per item
+template <class Kind> static void scattered(bench::State &state) {
+  using Ptr = decltype(Kind::template make<TypedDouble>(0.0));
+  std::vector<Ptr> live;
+  for (int64_t i = 0; i < state.range(0); ++i)
+    live.push_back(Kind::template make<TypedDouble>(double(i)));
+  uint64_t s = 88172645463325252ull;
+  for (auto _ : state) {
+    uint64_t r = xorshift(s);
+    live[r % live.size()] = Kind::template make<TypedDouble>(double(r));
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(scattered, NewDelete)->range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(scattered, Slab<false>)->range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(scattered, Slab<true>)->range(1 << 10, 1 << 20);
+
+// range(0) threads, each allocating 64 objects and freeing them again
+template <class Kind> static void threads(bench::State &state) {
+  constexpr int kRounds = 1 << 10;
+  for (auto _ : state) {
+    std::vector<std::thread> workers;
+    for (int64_t t = 0; t < state.range(0); ++t)
+      workers.emplace_back([] {
+        using Ptr = decltype(Kind::template make<TypedDouble>(0.0));
+        std::vector<Ptr> held(64);
+        for (int r = 0; r < kRounds; ++r) {
+          for (auto &p : held)
+            p = Kind::template make<TypedDouble>(double(r));
+          for (auto &p : held)
+            p = Ptr();
+        }
+      });
+    for (auto &w : workers)
+      w.join();
+  }
+  state.setItemsProcessed(state.iterations() * state.range(0) * kRounds * 64);
+}
+BENCHMARK_TEMPLATE(threads, NewDelete)->rangeMultiplier(2)->range(1, 8);
+BENCHMARK_TEMPLATE(threads, Slab<false>)->rangeMultiplier(2)->range(1, 8);
+BENCHMARK_TEMPLATE(threads, Slab<true>)->rangeMultiplier(2)->range(1, 8);
+
+// 2^18 objects, a random 3/4 of them freed, 2^16 more allocated
+template <class Kind> static void fragmentation(bench::State &state) {
+  using Ptr = decltype(Kind::template make<TypedVec3>(value<TypedVec3>(0)));
+  double held = 0, used = 0;
+  for (auto _ : state) {
+    std::vector<Ptr> live;
+    for (uint64_t i = 0; i < (1 << 18); ++i)
+      live.push_back(Kind::template make<TypedVec3>(value<TypedVec3>(i)));
+    uint64_t s = 88172645463325252ull;
+    std::erase_if(live, [&](const Ptr &) { return xorshift(s) % 4 != 0; });
+    for (uint64_t i = 0; i < (1 << 16); ++i)
+      live.push_back(Kind::template make<TypedVec3>(value<TypedVec3>(i)));
+    held = double(Kind::template heldBytes<TypedVec3>()) / double(live.size());
+    used = double(Kind::template usedBytes<TypedVec3>()) / double(live.size());
+  }
+  state.counters["heapBytes/live"] = held;
+  state.counters["usedBytes/live"] = used;
+  state.setItemsProcessed(state.iterations() * ((1 << 18) + (1 << 16)));
+}
+BENCHMARK_TEMPLATE(fragmentation, NewDelete);
+BENCHMARK_TEMPLATE(fragmentation, Slab<true>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,151 @@
+// SlotMap<T> with Id<T> handles against a std::unordered_map from a
+// counter-assigned uint64_t id, holding range(0) TypedClass<double>s:
+// looking up a random handle, going through every element, and erasing a
+// random element and inserting another in its place.
+//
+// SlotMap is first checked against an unordered_map through a random
+// sequence of inserts and erases, stale handles included.
+
+#include "../slotMap.hpp"
+#include "benchHarness.hpp"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+using TypedDouble = TypedClass<double, SilentPolicy>;
+
+static uint64_t xorshift(uint64_t &s) {
+  s ^= s << 13;
+  s ^= s >> 7;
+  s ^= s << 17;
+  return s;
+}
+
+static void checkSlotMap() {
+  SlotMap<TypedDouble> m;
+  std::vector<std::pair<Id<TypedDouble>, double>> live, dead;
+  uint64_t s = 88172645463325252ull;
+  for (int i = 0; i < 100'000; ++i) {
+    uint64_t r = xorshift(s);
+    if (live.empty() || r % 3) {
+      double v = double(i);
+      live.push_back({m.insert(v), v});
+    } else {
+      size_t k = r / 3 % live.size();
+      if (!m.erase(live[k].first) || m.erase(live[k].first))
+        bench::fail("erase of a live element didn't erase it once");
+      dead.push_back(live[k]);
+      live[k] = live.back();
+      live.pop_back();
+    }
+  }
+  if (m.size() != live.size())
+    bench::fail("size() is off");
+  for (auto &[id, v] : live)
+    if (!m.find(id) || m.find(id)->getData() != v)
+      bench::fail("a live handle doesn't find its element");
+  for (auto &[id, v] : dead)
+    if (m.find(id) || m.contains(id))
+      bench::fail("a stale handle found an element");
+  if (m.find(Id<TypedDouble>()))
+    bench::fail("a default Id found an element");
+  for (size_t i = 0; i < m.size(); ++i)
+    if (m.find(m.idAt(i)) != m.data() + i)
+      bench::fail("idAt() doesn't name the element at that position");
+  double sum = 0, expected = 0;
+  for (auto &x : m)
+    sum += x.getData();
+  for (auto &[id, v] : live)
+    expected += v;
+  if (sum != expected)
+    bench::fail("the dense elements aren't the live ones");
+  m.clear();
+  for (auto &[id, v] : live)
+    if (m.find(id))
+      bench::fail("clear() left a handle valid");
+}
+
+BENCHMARK_CHECK(checkSlotMap);
+
+struct Slots {
+  using Handle = Id<TypedDouble>;
+  SlotMap<TypedDouble> m;
+
+  Handle insert(double v) { return m.insert(v); }
+  TypedDouble *find(Handle h) { return m.find(h); }
+  void erase(Handle h) { m.erase(h); }
+  double sum() {
+    double s = 0;
+    for (auto &x : m)
+      s += x.getData();
+    return s;
+  }
+};
+
+struct Hashed {
+  using Handle = uint64_t;
+  std::unordered_map<uint64_t, TypedDouble> m;
+  uint64_t next = 1;
+
+  Handle insert(double v) {
+    m.emplace(next, v);
+    return next++;
+  }
+  TypedDouble *find(Handle h) {
+    auto it = m.find(h);
+    return it == m.end() ? nullptr : &it->second;
+  }
+  void erase(Handle h) { m.erase(h); }
+  double sum() {
+    double s = 0;
+    for (auto &[id, x] : m)
+      s += x.getData();
+    return s;
+  }
+};
+
+template <class Kind>
+static std::vector<typename Kind::Handle> fill(Kind &k, int64_t n) {
+  std::vector<typename Kind::Handle> handles;
+  for (int64_t i = 0; i < n; ++i)
+    handles.push_back(k.insert(double(i)));
+  return handles;
+}
+
+template <class Kind> static void lookup(bench::State &state) {
+  Kind k;
+  auto handles = fill(k, state.range(0));
+  uint64_t s = 88172645463325252ull;
+  for (auto _ : state)
+    bench::doNotOptimize(k.find(handles[xorshift(s) % handles.size()]));
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(lookup, Hashed)->range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(lookup, Slots)->range(1 << 10, 1 << 20);
+
+template <class Kind> static void iterate(bench::State &state) {
+  Kind k;
+  fill(k, state.range(0));
+  for (auto _ : state)
+    bench::doNotOptimize(k.sum());
+  state.setItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_TEMPLATE(iterate, Hashed)->range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(iterate, Slots)->range(1 << 10, 1 << 20);
+
+template <class Kind> static void churn(bench::State &state) {
+  Kind k;
+  auto handles = fill(k, state.range(0));
+  uint64_t s = 88172645463325252ull;
+  for (auto _ : state) {
+    auto &h = handles[xorshift(s) % handles.size()];
+    k.erase(h);
+    h = k.insert(double(s));
+  }
+  state.setItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(churn, Hashed)->range(1 << 10, 1 << 20);
+BENCHMARK_TEMPLATE(churn, Slots)->range(1 << 10, 1 << 20);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,220 @@
+#pragma once
+
+// Recycles the buffers of short-lived containers instead of going back to
+// malloc for each one.
+//
+// Requests are rounded up to power-of-two size classes from 64 bytes to
+// kMaxBytes (1MB); anything larger goes straight to operator new. Each
+// thread keeps a small stack of free buffers per class, so churning arrays
+// of one size costs a pop and a push on thread-local memory. A stack that
+// overflows hands half of itself to the class's depot as one batch, and
+// one that runs dry takes a batch back: the depot is a bounded lock-free
+// queue of batches shared by all threads, and when it's full the overflow
+// is freed. So a buffer may be freed on another thread than the one that
+// allocated it, and what the pool holds on to is bounded by kDepotBatches
+// batches per class plus the threads' stacks.
+//
+//   PooledDynamicArray<int> a(100); // DynamicArray<int, PoolAllocator<int>>
+//
+// Buffers freed after their thread's stacks were flushed at thread exit go
+// straight back to operator delete.
+
+#include "dynamicArray.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace bufferPool {
+inline constexpr unsigned kMinShift = 6;  // 64-byte buffers and up
+inline constexpr unsigned kMaxShift = 20; // up to 1MB
+inline constexpr unsigned kClasses = kMaxShift - kMinShift + 1;
+inline constexpr size_t kMaxBytes = size_t(1) << kMaxShift;
+inline constexpr size_t kDepotBatches = 64;
+inline constexpr unsigned kMaxCached = 64;
+
+constexpr unsigned sizeClass(size_t bytes) {
+  return bytes <= (size_t(1) << kMinShift)
+             ? 0
+             : unsigned(std::bit_width(bytes - 1)) - kMinShift;
+}
+constexpr size_t classBytes(unsigned c) { return size_t(1) << (c + kMinShift); }
+
+// Free buffers a thread keeps per class: 256KB worth, at least 4
+constexpr unsigned cacheLimit(unsigned c) {
+  return unsigned(std::clamp<size_t>((size_t(256) << 10) / classBytes(c), 4,
+                                     kMaxCached));
+}
+
+// A free buffer, linked through its first word into a batch
+struct FreeBuffer {
+  FreeBuffer *next;
+};
+
+// A bounded multi-producer, multi-consumer queue of batches (Vyukov's).
+// Each cell's sequence number is stored minus the cell's index, so a
+// zero-initialized Depot is an empty one.
+class Depot {
+  struct Cell {
+    std::atomic<size_t> seq{0};
+    FreeBuffer *batch = nullptr;
+  };
+  alignas(64) std::atomic<size_t> tail{0};
+  alignas(64) std::atomic<size_t> head{0};
+  alignas(64) Cell cells[kDepotBatches];
+
+public:
+  // false if the depot is full
+  bool push(FreeBuffer *batch) {
+    size_t pos = tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &c = cells[pos % kDepotBatches];
+      size_t seq = c.seq.load(std::memory_order_acquire) + pos % kDepotBatches;
+      auto dif = intptr_t(seq) - intptr_t(pos);
+      if (dif == 0) {
+        if (tail.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          c.batch = batch;
+          c.seq.store(pos + 1 - pos % kDepotBatches,
+                      std::memory_order_release);
+          return true;
+        }
+      } else if (dif < 0) {
+        return false;
+      } else {
+        pos = tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // nullptr if the depot is empty
+  FreeBuffer *pop() {
+    size_t pos = head.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &c = cells[pos % kDepotBatches];
+      size_t seq = c.seq.load(std::memory_order_acquire) + pos % kDepotBatches;
+      auto dif = intptr_t(seq) - intptr_t(pos + 1);
+      if (dif == 0) {
+        if (head.compare_exchange_weak(pos, pos + 1,
+                                       std::memory_order_relaxed)) {
+          FreeBuffer *batch = c.batch;
+          c.seq.store(pos + kDepotBatches - pos % kDepotBatches,
+                      std::memory_order_release);
+          return batch;
+        }
+      } else if (dif < 0) {
+        return nullptr;
+      } else {
+        pos = head.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
+
+inline constinit Depot depots[kClasses];
+
+// Trivial and constant-initialized, like allocTracker's, so it can be used
+// at any point in a thread's life
+struct ThreadCache {
+  void *free[kClasses][kMaxCached];
+  unsigned count[kClasses];
+  bool flushing; // registered for flushing at thread exit
+  bool closed;   // flushed; pass everything through to operator new/delete
+};
+inline thread_local constinit ThreadCache tls{};
+
+inline void freeBatch(FreeBuffer *b) {
+  while (b) {
+    FreeBuffer *next = b->next;
+    ::operator delete(b);
+    b = next;
+  }
+}
+
+// Moves the top n buffers of class c to the depot, or frees them if it's full
+inline void flush(ThreadCache &t, unsigned c, unsigned n) {
+  FreeBuffer *batch = nullptr;
+  for (unsigned i = 0; i < n; ++i) {
+    auto *b = static_cast<FreeBuffer *>(t.free[c][--t.count[c]]);
+    b->next = batch;
+    batch = b;
+  }
+  if (batch && !depots[c].push(batch))
+    freeBatch(batch);
+}
+
+struct Flusher {
+  ~Flusher() {
+    for (unsigned c = 0; c < kClasses; ++c)
+      while (tls.count[c])
+        flush(tls, c, std::min(tls.count[c], cacheLimit(c) / 2));
+    tls.closed = true;
+  }
+};
+
+inline ThreadCache *cache() {
+  ThreadCache &t = tls;
+  if (!t.flushing) [[unlikely]] {
+    static thread_local Flusher flusher;
+    (void)flusher;
+    t.flushing = true;
+  }
+  return t.closed ? nullptr : &t;
+}
+
+inline void *allocate(size_t bytes) {
+  if (bytes > kMaxBytes)
+    return ::operator new(bytes);
+  unsigned c = sizeClass(bytes);
+  ThreadCache *t = cache();
+  if (!t) [[unlikely]]
+    return ::operator new(classBytes(c));
+  if (t->count[c]) [[likely]]
+    return t->free[c][--t->count[c]];
+  FreeBuffer *batch = depots[c].pop();
+  if (!batch)
+    return ::operator new(classBytes(c));
+  for (FreeBuffer *b = batch->next; b; b = b->next)
+    t->free[c][t->count[c]++] = b;
+  return batch;
+}
+
+inline void deallocate(void *p, size_t bytes) {
+  if (bytes > kMaxBytes)
+    return ::operator delete(p);
+  unsigned c = sizeClass(bytes);
+  ThreadCache *t = cache();
+  if (!t) [[unlikely]]
+    return ::operator delete(p);
+  if (t->count[c] >= cacheLimit(c)) [[unlikely]]
+    flush(*t, c, cacheLimit(c) / 2);
+  t->free[c][t->count[c]++] = p;
+}
+} // namespace bufferPool
+
+template <class T> struct PoolAllocator {
+  static_assert(alignof(T) <= __STDCPP_DEFAULT_NEW_ALIGNMENT__,
+                "PoolAllocator hands out operator new's alignment");
+  using value_type = T;
+
+  PoolAllocator() = default;
+  template <class U> PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+  T *allocate(size_t n) {
+    if (n > SIZE_MAX / sizeof(T))
+      throw std::bad_array_new_length();
+    return static_cast<T *>(bufferPool::allocate(n * sizeof(T)));
+  }
+  void deallocate(T *p, size_t n) noexcept {
+    bufferPool::deallocate(p, n * sizeof(T));
+  }
+
+  template <class U> bool operator==(const PoolAllocator<U> &) const {
+    return true;
+  }
+};
+
+template <class T> using PooledDynamicArray = DynamicArray<T, PoolAllocator<T>>;
@@ -0,0 +1,150 @@
+#pragma once
+
+// Copying big arrays of trivially copyable elements on several threads.
+//
+// A std::vector copy is one memmove on the copying thread: for gigabytes
+// that's one core's share of the memory bandwidth, plus every page fault of
+// the new buffer taken one after the other, and a destination that pushes
+// everything else out of the cache on its way through. bulkCopy::copy()
+// splits the bytes into one page-aligned part per thread (the calling
+// thread takes the first), and when the copy is bigger than the last-level
+// cache writes it with streaming stores, which go around the cache.
+//
+// BulkCopyDynamicArray<T> is a DynamicArray whose copy constructor goes
+// through it:
+//
+//   BulkCopyDynamicArray<double> prices(size_t(1) << 30, 0.0);
+//   BulkCopyDynamicArray<double> snapshot(prices); // copied on every core
+//
+// Its allocator leaves elements default-initialized, so that the copy
+// writes each byte once; which also means getArr().resize() leaves new
+// elements uninitialized, as new T[n] would.
+
+#include "dynamicArray.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace bulkCopy {
+// Smaller copies aren't worth starting a thread for
+inline constexpr size_t kMinBytesPerThread = size_t(32) << 20;
+
+// Threads a copy may use when it doesn't say; 0: one per hardware thread
+inline std::atomic<unsigned> defaultThreads{0};
+
+// Calls of copy() so far
+inline std::atomic<uint64_t> copies{0};
+
+inline size_t lastLevelCacheBytes() {
+  static const size_t bytes = [] {
+    for (int level : {_SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE})
+      if (long n = sysconf(level); n > 0)
+        return size_t(n);
+    return size_t(32) << 20;
+  }();
+  return bytes;
+}
+
+// memcpy, storing around the cache where the CPU lets us
+inline void streamCopy(char *dst, const char *src, size_t bytes) {
+#ifdef __SSE2__
+  size_t head = std::min(bytes, size_t(-uintptr_t(dst) & 15));
+  std::memcpy(dst, src, head);
+  dst += head, src += head, bytes -= head;
+  for (; bytes >= 64; dst += 64, src += 64, bytes -= 64) {
+    auto *s = reinterpret_cast<const __m128i *>(src);
+    __m128i a = _mm_loadu_si128(s), b = _mm_loadu_si128(s + 1),
+            c = _mm_loadu_si128(s + 2), d = _mm_loadu_si128(s + 3);
+    auto *o = reinterpret_cast<__m128i *>(dst);
+    _mm_stream_si128(o, a);
+    _mm_stream_si128(o + 1, b);
+    _mm_stream_si128(o + 2, c);
+    _mm_stream_si128(o + 3, d);
+  }
+  _mm_sfence(); // streaming stores aren't ordered with the ones that follow
+#endif
+  std::memcpy(dst, src, bytes);
+}
+
+// Copies bytes from src to dst, which mustn't overlap, on up to `threads`
+// threads (0: defaultThreads). A thread that can't be started leaves its
+// part to the calling thread.
+inline void copy(void *dst, const void *src, size_t bytes,
+                 unsigned threads = 0) {
+  copies.fetch_add(1, std::memory_order_relaxed);
+  if (threads == 0)
+    threads = defaultThreads.load(std::memory_order_relaxed);
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = unsigned(
+      std::clamp<size_t>(bytes / kMinBytesPerThread, 1, threads));
+  bool stream = bytes > lastLevelCacheBytes();
+
+  constexpr size_t kPage = 4096;
+  size_t part = (bytes / threads + kPage - 1) / kPage * kPage;
+  auto copyPart = [&](unsigned i) {
+    size_t begin = std::min(bytes, i * part);
+    size_t n = std::min(bytes - begin, part);
+    char *d = static_cast<char *>(dst) + begin;
+    const char *s = static_cast<const char *>(src) + begin;
+    if (stream)
+      streamCopy(d, s, n);
+    else if (n)
+      std::memcpy(d, s, n);
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; ++t) {
+    try {
+      pool.emplace_back(copyPart, t);
+    } catch (const std::system_error &) {
+      copyPart(t);
+    }
+  }
+  copyPart(0);
+  for (auto &t : pool)
+    t.join();
+}
+} // namespace bulkCopy
+
+// std::allocator, except that it default-initializes, and has a bulkCopy()
+// that DynamicArray's copy constructor uses instead of the vector's copy
+template <class T> struct BulkCopyAllocator : std::allocator<T> {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "BulkCopyAllocator copies elements as bytes");
+  template <class U> struct rebind {
+    using other = BulkCopyAllocator<U>;
+  };
+
+  BulkCopyAllocator() = default;
+  template <class U> BulkCopyAllocator(const BulkCopyAllocator<U> &) noexcept {}
+
+  template <class U> void construct(U *p) noexcept(
+      std::is_nothrow_default_constructible_v<U>) {
+    ::new (static_cast<void *>(p)) U;
+  }
+  template <class U, class... Args> void construct(U *p, Args &&...args) {
+    std::construct_at(p, std::forward<Args>(args)...);
+  }
+
+  static void bulkCopy(T *dst, const T *src, size_t n) {
+    ::bulkCopy::copy(dst, src, n * sizeof(T));
+  }
+};
+
+template <class T>
+using BulkCopyDynamicArray = DynamicArray<T, BulkCopyAllocator<T>>;
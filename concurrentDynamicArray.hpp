@@ -0,0 +1,291 @@
+#pragma once
+
+// An append-only array that readers can go through while a writer grows it.
+//
+// A std::vector that reallocates frees the buffer any reader on another
+// thread may still be in the middle of. ConcurrentDynamicArray<T> keeps its
+// elements in a buffer that readers reach through one atomic pointer. A
+// writer that runs out of room copies the elements into a buffer twice the
+// size, publishes it, and retires the old one to epochDomain(), which frees
+// it once no reader can still be using it:
+//
+//   ConcurrentDynamicArray<int> a;
+//   a.push_back(1);                 // writers: any thread, one at a time
+//
+//   auto snap = a.read();           // readers: any thread, lock-free
+//   for (int x : snap)              // the elements there were at read()
+//     use(x);
+//
+// A Snapshot holds an epoch open for as long as it lives, and keeps every
+// buffer retired since then alive, so readers should let go of one when
+// they're done rather than keep it around. Elements are never changed in
+// place, so what a snapshot shows stays consistent; clear() publishes an
+// empty buffer instead of destroying elements readers may be looking at.
+//
+// Reclamation is epoch-based: epochDomain() keeps a global epoch, and a
+// record per reader thread of the epoch it entered in. A buffer retired in
+// epoch e may be freed once every reader inside a read() entered after e;
+// it is freed by the next retire() or collect() after that, not as the
+// last snapshot goes away. Destroying an array collects too, but buffers
+// held back then by readers of other arrays wait for another one.
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+class EpochDomain {
+public:
+  // Keeps anything retired from now on alive until its destruction; may be
+  // nested
+  class Guard {
+  public:
+    explicit Guard(EpochDomain &d) : domain(d) { domain.enter(); }
+    ~Guard() { domain.leave(); }
+    Guard(const Guard &) = delete;
+    Guard &operator=(const Guard &) = delete;
+
+  private:
+    EpochDomain &domain;
+  };
+
+  // Frees p with destroy(p) once every reader that might still see it has
+  // left
+  void retire(void *p, void (*destroy)(void *)) {
+    uint64_t e = epoch.fetch_add(1, std::memory_order_seq_cst);
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      retired.push_back({p, destroy, e});
+    }
+    collect();
+  }
+
+  // Frees what no reader can see any more; retire() calls it too
+  void collect() {
+    // Only what was retired before the readers were looked at: a reader
+    // that arrives after that may still see what's retired later
+    uint64_t oldest = epoch.load(std::memory_order_seq_cst);
+    for (Record *r = records.load(std::memory_order_acquire); r; r = r->next)
+      if (uint64_t e = r->epoch.load(std::memory_order_seq_cst))
+        oldest = std::min(oldest, e);
+    std::vector<Retired> ready;
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      auto it = std::partition(
+          retired.begin(), retired.end(),
+          [&](const Retired &r) { return r.epoch >= oldest; });
+      ready.assign(it, retired.end());
+      retired.erase(it, retired.end());
+    }
+    for (const Retired &r : ready)
+      r.destroy(r.p);
+  }
+
+  // Retired but not yet freed
+  size_t pending() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return retired.size();
+  }
+
+private:
+  // One per reader thread, reused after the thread exits; never freed
+  struct alignas(64) Record {
+    std::atomic<uint64_t> epoch{0}; // 0: not reading
+    std::atomic<bool> taken{true};
+    Record *next = nullptr;
+  };
+  struct Retired {
+    void *p;
+    void (*destroy)(void *);
+    uint64_t epoch;
+  };
+
+  std::atomic<uint64_t> epoch{1};
+  std::atomic<Record *> records{nullptr};
+  mutable std::mutex lock;
+  std::vector<Retired> retired;
+
+  // Trivial, like allocTracker's, with a Releaser giving the record back at
+  // thread exit. Per thread rather than per domain: there's only ever one.
+  struct ThreadState {
+    Record *record;
+    unsigned depth;
+  };
+  static inline thread_local constinit ThreadState tls{};
+  struct Releaser {
+    ~Releaser() {
+      tls.record->taken.store(false, std::memory_order_release);
+      tls.record = nullptr;
+    }
+  };
+
+  Record *record() {
+    if (tls.record) [[likely]]
+      return tls.record;
+    Record *r = records.load(std::memory_order_acquire);
+    for (; r; r = r->next) {
+      bool expected = false;
+      if (!r->taken.load(std::memory_order_relaxed) &&
+          r->taken.compare_exchange_strong(expected, true,
+                                           std::memory_order_acquire))
+        break;
+    }
+    if (!r) {
+      r = new Record;
+      r->next = records.load(std::memory_order_relaxed);
+      while (!records.compare_exchange_weak(r->next, r,
+                                            std::memory_order_release))
+        ;
+    }
+    tls.record = r;
+    static thread_local Releaser releaser;
+    (void)releaser;
+    return r;
+  }
+
+  // The store is seq_cst so that a writer's later look at the records,
+  // after it has published a new buffer, either sees this reader or comes
+  // before it in the order of seq_cst operations, so that the reader's
+  // load of the buffer sees the new one
+  void enter() {
+    if (tls.depth++)
+      return;
+    record()->epoch.store(epoch.load(std::memory_order_seq_cst),
+                          std::memory_order_seq_cst);
+  }
+  void leave() {
+    if (--tls.depth == 0)
+      tls.record->epoch.store(0, std::memory_order_release);
+  }
+
+  friend EpochDomain &epochDomain();
+  EpochDomain() = default;
+};
+
+// Never destroyed, so readers and writers with static storage can use it
+inline EpochDomain &epochDomain() {
+  static auto *domain = new EpochDomain;
+  return *domain;
+}
+
+template <class T> class ConcurrentDynamicArray {
+  static_assert(std::is_copy_constructible_v<T>,
+                "growing copies the elements; readers still see the old ones");
+
+  struct Buffer {
+    T *elems;
+    size_t capacity;
+    std::atomic<size_t> count{0}; // constructed and visible to readers
+
+    explicit Buffer(size_t capacity)
+        : elems(capacity ? std::allocator<T>().allocate(capacity) : nullptr),
+          capacity(capacity) {}
+    ~Buffer() {
+      std::destroy_n(elems, count.load(std::memory_order_relaxed));
+      if (elems)
+        std::allocator<T>().deallocate(elems, capacity);
+    }
+  };
+
+public:
+  // The elements there were when it was taken
+  class Snapshot {
+  public:
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T &operator[](size_t i) const { return elems[i]; }
+    const T *data() const { return elems; }
+    const T *begin() const { return elems; }
+    const T *end() const { return elems + count; }
+
+  private:
+    EpochDomain::Guard guard;
+    const T *elems;
+    size_t count;
+
+    explicit Snapshot(const ConcurrentDynamicArray &a) : guard(epochDomain()) {
+      Buffer *b = a.current.load(std::memory_order_seq_cst);
+      count = b->count.load(std::memory_order_acquire);
+      elems = b->elems;
+    }
+    friend class ConcurrentDynamicArray;
+  };
+
+  ConcurrentDynamicArray() : current(new Buffer(0)) {}
+  ConcurrentDynamicArray(std::initializer_list<T> init)
+      : ConcurrentDynamicArray() {
+    reserve(init.size());
+    for (const T &x : init)
+      push_back(x);
+  }
+  ConcurrentDynamicArray(const ConcurrentDynamicArray &) = delete;
+  ConcurrentDynamicArray &operator=(const ConcurrentDynamicArray &) = delete;
+  // No reader may be left. Buffers retired earlier, which no snapshot of
+  // this array holds back any more, are freed here too.
+  ~ConcurrentDynamicArray() {
+    delete current.load(std::memory_order_relaxed);
+    epochDomain().collect();
+  }
+
+  Snapshot read() const { return Snapshot(*this); }
+
+  size_t size() const {
+    return current.load(std::memory_order_acquire)
+        ->count.load(std::memory_order_acquire);
+  }
+  size_t capacity() const {
+    return current.load(std::memory_order_acquire)->capacity;
+  }
+
+  void reserve(size_t n) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    Buffer *b = current.load(std::memory_order_relaxed);
+    if (n > b->capacity)
+      publish(b, grown(b, n).release());
+  }
+  void push_back(const T &x) { emplace_back(x); }
+  void push_back(T &&x) { emplace_back(std::move(x)); }
+  // args may refer to an element: the old buffer outlives the call
+  template <class... Args> void emplace_back(Args &&...args) {
+    std::lock_guard<std::mutex> guard(writeLock);
+    Buffer *b = current.load(std::memory_order_relaxed);
+    size_t n = b->count.load(std::memory_order_relaxed);
+    if (n < b->capacity) {
+      std::construct_at(b->elems + n, std::forward<Args>(args)...);
+      b->count.store(n + 1, std::memory_order_release);
+      return;
+    }
+    std::unique_ptr<Buffer> fresh = grown(b, std::max<size_t>(2 * n, 8));
+    std::construct_at(fresh->elems + n, std::forward<Args>(args)...);
+    fresh->count.store(n + 1, std::memory_order_relaxed);
+    publish(b, fresh.release());
+  }
+  // Readers still see the old elements until they take a new snapshot
+  void clear() {
+    std::lock_guard<std::mutex> guard(writeLock);
+    publish(current.load(std::memory_order_relaxed), new Buffer(0));
+  }
+
+private:
+  std::atomic<Buffer *> current;
+  std::mutex writeLock;
+
+  // A copy of b with room for n
+  static std::unique_ptr<Buffer> grown(Buffer *b, size_t n) {
+    auto fresh = std::make_unique<Buffer>(n);
+    size_t count = b->count.load(std::memory_order_relaxed);
+    std::uninitialized_copy_n(b->elems, count, fresh->elems);
+    fresh->count.store(count, std::memory_order_relaxed);
+    return fresh;
+  }
+  void publish(Buffer *old, Buffer *fresh) {
+    current.store(fresh, std::memory_order_seq_cst);
+    epochDomain().retire(old, [](void *p) { delete static_cast<Buffer *>(p); });
+  }
+};
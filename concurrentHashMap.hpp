@@ -0,0 +1,239 @@
+#pragma once
+
+// A hash map for small keys and values that many threads read at once,
+// such as tables keyed by typeId<T>() (typeUtils.hpp) or by handles.
+//
+//   ConcurrentHashMap<uint64_t, const Codec *> codecs;
+//   codecs.assign(typeId<Quote>(), &quoteCodec);  // writers: any thread
+//   if (auto c = codecs.find(typeId<Quote>()))    // readers: lock-free
+//     (*c)->encode(...);
+//
+// Keys and values are trivially copyable and at most 8 bytes, so that a
+// slot's key and value are single atomic words; store a pointer or an
+// index for anything bigger. The all-zero key is reserved for empty slots.
+//
+// The table uses open addressing with linear probing. A slot, once given
+// to a key, keeps it until the next resize: erasing marks it dead, and
+// inserting the key again revives it. A reader probes without taking a
+// lock and never sees a key move, or a value half-written. Writers lock
+// one of kStripes mutexes picked by the key's hash, so updates of the same
+// key are serialized and claims of an empty slot by different keys are
+// settled by compare-and-swap.
+//
+// When the claimed slots pass 3/4 of the table, a writer takes every stripe,
+// builds a new table from the live entries and publishes it. The old table
+// goes to epochDomain() (concurrentDynamicArray.hpp), so readers still in
+// it carry on undisturbed. Writers wait out the rebuild, and readers don't.
+
+#include "concurrentDynamicArray.hpp"
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+
+template <class K, class V> class ConcurrentHashMap {
+  static_assert(std::is_trivially_copyable_v<K> && sizeof(K) <= 8 &&
+                    std::has_unique_object_representations_v<K>,
+                "keys are compared and stored as one 64-bit word");
+  static_assert(std::is_trivially_copyable_v<V> && sizeof(V) <= 8,
+                "values are stored as one 64-bit word");
+
+public:
+  static constexpr size_t kStripes = 64;
+
+  explicit ConcurrentHashMap(size_t expected = 0)
+      : table(new Table(capacityFor(expected))) {}
+  ConcurrentHashMap(const ConcurrentHashMap &) = delete;
+  ConcurrentHashMap &operator=(const ConcurrentHashMap &) = delete;
+  // No reader may be left; tables replaced earlier are freed by the domain
+  ~ConcurrentHashMap() { delete table.load(std::memory_order_relaxed); }
+
+  std::optional<V> find(K key) const {
+    uint64_t k = toBits(key);
+    EpochDomain::Guard guard(epochDomain());
+    const Table *t = table.load(std::memory_order_seq_cst);
+    for (size_t i = mix(k);; ++i) {
+      const Slot &s = t->slots[i & t->mask];
+      uint64_t sk = s.key.load(std::memory_order_acquire);
+      if (sk == k) {
+        if (!s.alive.load(std::memory_order_acquire))
+          return std::nullopt;
+        return fromBits(s.value.load(std::memory_order_acquire));
+      }
+      if (sk == 0)
+        return std::nullopt;
+    }
+  }
+  bool contains(K key) const { return find(key).has_value(); }
+
+  // Adds key -> value unless key is already there; true if it was added
+  bool insert(K key, V value) { return put(key, value, false); }
+  // Adds key -> value, or replaces key's value; true if it was added
+  bool assign(K key, V value) { return put(key, value, true); }
+
+  // true if key was there
+  bool erase(K key) {
+    uint64_t k = toBits(key);
+    std::lock_guard<std::mutex> guard(stripe(k));
+    Table *t = table.load(std::memory_order_relaxed);
+    for (size_t i = mix(k);; ++i) {
+      Slot &s = t->slots[i & t->mask];
+      uint64_t sk = s.key.load(std::memory_order_acquire);
+      if (sk == 0)
+        return false;
+      if (sk == k) {
+        if (!s.alive.load(std::memory_order_relaxed))
+          return false;
+        s.alive.store(false, std::memory_order_release);
+        live.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+  }
+
+  size_t size() const { return live.load(std::memory_order_relaxed); }
+  size_t capacity() const {
+    return table.load(std::memory_order_acquire)->mask + 1;
+  }
+  // Tables rebuilt so far
+  uint64_t resizes() const { return rebuilt.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> key{0}; // 0: empty
+    std::atomic<uint64_t> value{0};
+    std::atomic<bool> alive{false}; // set after value, so readers see it
+  };
+  struct Table {
+    size_t mask;
+    std::atomic<size_t> claimed{0}; // slots with a key, dead or alive
+    std::unique_ptr<Slot[]> slots;
+
+    explicit Table(size_t capacity)
+        : mask(capacity - 1), slots(new Slot[capacity]) {}
+    size_t limit() const { return (mask + 1) / 4 * 3; }
+  };
+  struct alignas(64) Stripe {
+    std::mutex lock;
+  };
+
+  std::atomic<Table *> table;
+  std::atomic<size_t> live{0};
+  std::atomic<uint64_t> rebuilt{0};
+  mutable Stripe stripes[kStripes];
+
+  // Room for n entries below the 3/4 limit
+  static size_t capacityFor(size_t n) {
+    return std::bit_ceil(std::max<size_t>(16, n + n / 3 + 1));
+  }
+
+  template <class U> static uint64_t toBits(U x) {
+    uint64_t w = 0;
+    std::memcpy(&w, &x, sizeof x);
+    return w;
+  }
+  static V fromBits(uint64_t w) {
+    V v;
+    std::memcpy(&v, &w, sizeof v);
+    return v;
+  }
+
+  // splitmix64's finalizer: handles, ids and hashes all probe well with it
+  static size_t mix(uint64_t k) {
+    k ^= k >> 30;
+    k *= 0xbf58476d1ce4e5b9ull;
+    k ^= k >> 27;
+    k *= 0x94d049bb133111ebull;
+    return size_t(k ^ (k >> 31));
+  }
+  // The low bits pick the slot, so pick the stripe with the high ones
+  std::mutex &stripe(uint64_t k) const {
+    return stripes[(mix(k) >> 32) % kStripes].lock;
+  }
+
+  bool put(K key, V value, bool replace) {
+    uint64_t k = toBits(key);
+    assert(k != 0 && "the all-zero key is reserved");
+    std::unique_lock<std::mutex> guard(stripe(k));
+    for (;;) {
+      // Can't change while we hold a stripe
+      Table *t = table.load(std::memory_order_relaxed);
+      for (size_t i = mix(k);; ++i) {
+        Slot &s = t->slots[i & t->mask];
+        uint64_t sk = s.key.load(std::memory_order_acquire);
+        if (sk == k) {
+          bool wasAlive = s.alive.load(std::memory_order_relaxed);
+          if (wasAlive && !replace)
+            return false;
+          s.value.store(toBits(value), std::memory_order_release);
+          if (!wasAlive) {
+            s.alive.store(true, std::memory_order_release);
+            live.fetch_add(1, std::memory_order_relaxed);
+          }
+          return !wasAlive;
+        }
+        if (sk != 0)
+          continue;
+        // Booked before the slot is claimed, so that writers on other
+        // stripes can't fill the table between them
+        if (t->claimed.fetch_add(1, std::memory_order_relaxed) >= t->limit()) {
+          t->claimed.fetch_sub(1, std::memory_order_relaxed);
+          break;
+        }
+        if (!s.key.compare_exchange_strong(sk, k, std::memory_order_acq_rel)) {
+          t->claimed.fetch_sub(1, std::memory_order_relaxed);
+          continue; // another key took it first
+        }
+        s.value.store(toBits(value), std::memory_order_relaxed);
+        s.alive.store(true, std::memory_order_release);
+        live.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      }
+      guard.unlock();
+      rebuild(t);
+      guard.lock();
+    }
+  }
+
+  // Replaces `full` with a table sized for the live entries, unless another
+  // writer already has
+  void rebuild(Table *full) {
+    for (Stripe &s : stripes)
+      s.lock.lock();
+    if (Table *t = table.load(std::memory_order_relaxed); t == full) {
+      auto fresh = std::make_unique<Table>(
+          capacityFor(2 * live.load(std::memory_order_relaxed)));
+      size_t n = 0;
+      for (size_t i = 0; i <= t->mask; ++i) {
+        const Slot &from = t->slots[i];
+        if (!from.alive.load(std::memory_order_relaxed))
+          continue;
+        uint64_t k = from.key.load(std::memory_order_relaxed);
+        for (size_t j = mix(k);; ++j) {
+          Slot &to = fresh->slots[j & fresh->mask];
+          if (to.key.load(std::memory_order_relaxed) == 0) {
+            to.key.store(k, std::memory_order_relaxed);
+            to.value.store(from.value.load(std::memory_order_relaxed),
+                           std::memory_order_relaxed);
+            to.alive.store(true, std::memory_order_relaxed);
+            break;
+          }
+        }
+        ++n;
+      }
+      fresh->claimed.store(n, std::memory_order_relaxed);
+      table.store(fresh.release(), std::memory_order_seq_cst);
+      epochDomain().retire(t, [](void *p) { delete static_cast<Table *>(p); });
+      rebuilt.fetch_add(1, std::memory_order_relaxed);
+    }
+    for (Stripe &s : stripes)
+      s.lock.unlock();
+  }
+};
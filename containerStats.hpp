@@ -0,0 +1,77 @@
+#pragma once
+
+// Per-type construction counts and live DynamicArray memory, for exporting.
+//
+//   TypedClass<double, CountingPolicy> x;   // counted under "double"
+//   forEachTypeStats([](const TypeStats &s) {
+//     s.constructions[int(Construction::Copy)].load();
+//     s.liveArrayBytes.load();
+//   });
+//
+// TypedClass instances are counted when they use CountingPolicy. DynamicArray
+// buffers are counted, per element type, in code built with
+// INTERESTING_ARRAY_STATS defined (cmake -DENABLE_ARRAY_STATS=ON); the
+// capacity is what counts, so slack is included. Resizing the vector behind
+// getArr() directly skews the figure.
+//
+// Updates are relaxed atomic adds on the type's own counters, and the list
+// of types only ever grows, by a lock-free push, so readers never block
+// writers.
+
+#include "demangle.hpp"
+#include "typedClass.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct TypeStats {
+  const char *name; // demangled
+  std::atomic<uint64_t> constructions[4] = {}; // indexed by Construction
+  std::atomic<int64_t> liveArrayBytes = 0;     // DynamicArray<T> capacity
+  const TypeStats *next = nullptr;
+
+  explicit TypeStats(const char *name);
+  TypeStats(const TypeStats &) = delete;
+  TypeStats &operator=(const TypeStats &) = delete;
+};
+
+namespace containerStats {
+inline std::atomic<const TypeStats *> head{nullptr};
+
+#ifdef INTERESTING_ARRAY_STATS
+inline constexpr bool kArrayStats = true;
+#else
+inline constexpr bool kArrayStats = false;
+#endif
+} // namespace containerStats
+
+inline TypeStats::TypeStats(const char *name) : name(name) {
+  const TypeStats *old = containerStats::head.load(std::memory_order_relaxed);
+  do
+    next = old;
+  while (!containerStats::head.compare_exchange_weak(
+      old, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+// The counters of T, registered the first time they're asked for
+template <class T> TypeStats &typeStats() {
+  static TypeStats stats(typeName<T>());
+  return stats;
+}
+
+// Calls f(const TypeStats &) for every type counted so far
+template <class F> void forEachTypeStats(F &&f) {
+  for (const TypeStats *s = containerStats::head.load(std::memory_order_acquire);
+       s; s = s->next)
+    f(*s);
+}
+
+// A TypedClass policy that counts constructions per type
+struct CountingPolicy : SilentPolicy {
+  template <class T> void constructed(Construction how, const T &) {
+    typeStats<T>()
+        .constructions[static_cast<int>(how)]
+        .fetch_add(1, std::memory_order_relaxed);
+  }
+};
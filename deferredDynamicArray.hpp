@@ -0,0 +1,221 @@
+#pragma once
+
+// Opt-in background destruction of large DynamicArray buffers.
+//
+// Destroying a big array means running every element's destructor and
+// then handing the buffer back to the OS, which for an mmap'ed allocation
+// is an munmap of the whole range; for gigabytes that's milliseconds. A
+// DeferredDynamicArray<T> whose buffer is at least minBytes() passes it to
+// arrayReclaimer() instead, whose thread destroys it off the caller's path:
+//
+//   {
+//     DeferredDynamicArray<TypedClass<std::string, SilentPolicy>> a(1 << 24);
+//     ...
+//   } // the buffer is queued, not freed, here
+//   arrayReclaimer().drain(); // waits until everything queued is freed
+//
+// The queue is bounded by job count and by bytes. A thread that finds it
+// full waits for the reclaimer to catch up (counted in stalls()), so a
+// producer that outruns it is slowed down to its pace rather than letting
+// garbage pile up without limit.
+//
+// The element destructors run on the reclaimer thread, so they mustn't
+// depend on which thread they run on. Arrays nested in a deferred one are
+// destroyed right there on the reclaimer thread, not queued again. Move
+// assignment defers the buffer it drops too; copy assignment, and changes
+// made through getArr() or through a DynamicArray<T>&, free in place as
+// usual.
+
+#include "dynamicArray.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+class ArrayReclaimer {
+public:
+  struct Limits {
+    size_t minBytes = size_t(1) << 20; // smaller buffers free in place
+    size_t maxJobs = 64;               // queued buffers
+    size_t maxBytes = size_t(1) << 30; // queued capacity, in bytes
+    int nice = 10; // of the reclaimer thread, so it yields to the callers
+  };
+
+  ArrayReclaimer() : ArrayReclaimer(Limits()) {}
+  explicit ArrayReclaimer(Limits limits)
+      : limits(limits), ring(limits.maxJobs) {
+    worker = std::thread([this] { run(); });
+  }
+  // Frees whatever is still queued before returning
+  ~ArrayReclaimer() {
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      stopping = true;
+    }
+    notEmpty.notify_one();
+    worker.join();
+  }
+  ArrayReclaimer(const ArrayReclaimer &) = delete;
+  ArrayReclaimer &operator=(const ArrayReclaimer &) = delete;
+
+  size_t minBytes() const { return limits.minBytes; }
+
+  // Queues v for destruction on the reclaimer thread, waiting while the
+  // queue is full. A buffer bigger than maxBytes is still taken, once the
+  // queue is empty. If there's no memory left to queue it with, v is
+  // destroyed right here.
+  template <class T> void defer(std::vector<T> &&v) {
+    size_t bytes = v.capacity() * sizeof(T);
+    auto *owned = new (std::nothrow) std::vector<T>(std::move(v));
+    if (!owned)
+      return;
+    enqueue({owned,
+             [](void *p, size_t) { delete static_cast<std::vector<T> *>(p); },
+             bytes});
+  }
+
+  // The same for raw storage from std::allocator<T>, whose elements are
+  // already destroyed
+  template <class T> void deferDeallocate(T *p, size_t n) {
+    enqueue({p,
+             [](void *p, size_t bytes) {
+               std::allocator<T>().deallocate(static_cast<T *>(p),
+                                              bytes / sizeof(T));
+             },
+             n * sizeof(T)});
+  }
+
+  // Waits until everything queued before the call has been destroyed
+  void drain() {
+    std::unique_lock<std::mutex> guard(lock);
+    uint64_t target = submitted;
+    idle.wait(guard, [&] { return finished >= target; });
+  }
+
+  uint64_t deferred() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return submitted;
+  }
+  uint64_t reclaimed() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return finished;
+  }
+  // How many defer() calls had to wait for room
+  uint64_t stalls() const { return stalled.load(std::memory_order_relaxed); }
+
+private:
+  struct Job {
+    void *buffer = nullptr;
+    void (*destroy)(void *buffer, size_t bytes) = nullptr;
+    size_t bytes = 0;
+  };
+
+  Limits limits;
+  mutable std::mutex lock;
+  std::condition_variable notEmpty, notFull, idle;
+  std::vector<Job> ring;
+  size_t head = 0;
+  size_t queued = 0;
+  size_t queuedBytes = 0;
+  uint64_t submitted = 0;
+  uint64_t finished = 0;
+  bool stopping = false;
+  std::atomic<uint64_t> stalled{0};
+  std::thread worker;
+
+  void enqueue(Job job) {
+    // A destructor running here that defers a buffer of its own would
+    // otherwise wait for room that only this thread can make
+    if (std::this_thread::get_id() == worker.get_id())
+      return job.destroy(job.buffer, job.bytes);
+    std::unique_lock<std::mutex> guard(lock);
+    auto full = [&] {
+      return queued == ring.size() ||
+             (queued && queuedBytes + job.bytes > limits.maxBytes);
+    };
+    if (full()) {
+      stalled.fetch_add(1, std::memory_order_relaxed);
+      notFull.wait(guard, [&] { return !full(); });
+    }
+    ring[(head + queued) % ring.size()] = job;
+    ++queued;
+    queuedBytes += job.bytes;
+    ++submitted;
+    guard.unlock();
+    notEmpty.notify_one();
+  }
+
+  // Takes one job at a time, so its bytes count against maxBytes until the
+  // job is done with
+  void run() {
+    // Linux applies this to the calling thread only
+    [[maybe_unused]] int r = setpriority(PRIO_PROCESS, 0, limits.nice);
+    std::unique_lock<std::mutex> guard(lock);
+    for (;;) {
+      notEmpty.wait(guard, [&] { return queued || stopping; });
+      if (!queued)
+        return;
+      Job job = ring[head];
+      guard.unlock();
+      job.destroy(job.buffer, job.bytes);
+      guard.lock();
+      head = (head + 1) % ring.size();
+      --queued;
+      queuedBytes -= job.bytes;
+      ++finished;
+      notFull.notify_all();
+      idle.notify_all();
+    }
+  }
+};
+
+inline ArrayReclaimer &arrayReclaimer() {
+  static ArrayReclaimer reclaimer;
+  return reclaimer;
+}
+
+// A base listed ahead of DynamicArray<T>, so the reclaimer is constructed
+// before, and destroyed after, any array that may use it; even one with
+// static storage
+struct UsesArrayReclaimer {
+  UsesArrayReclaimer() { arrayReclaimer(); }
+};
+
+template <class T>
+class DeferredDynamicArray : private UsesArrayReclaimer,
+                             public DynamicArray<T> {
+  using Base = DynamicArray<T>;
+
+  bool large() const {
+    return this->getArr().capacity() * sizeof(T) >= arrayReclaimer().minBytes();
+  }
+
+public:
+  using Base::Base;
+  DeferredDynamicArray() = default;
+  DeferredDynamicArray(const DeferredDynamicArray &) = default;
+  DeferredDynamicArray(DeferredDynamicArray &&) noexcept = default;
+  DeferredDynamicArray &operator=(const DeferredDynamicArray &) = default;
+  // Doesn't throw, like the destructor: defer() frees in place when it
+  // can't queue
+  DeferredDynamicArray &operator=(DeferredDynamicArray &&o) noexcept {
+    if (&o != this && large())
+      arrayReclaimer().defer(this->release());
+    Base::operator=(std::move(o));
+    return *this;
+  }
+  ~DeferredDynamicArray() {
+    if (large())
+      arrayReclaimer().defer(this->release());
+  }
+};
@@ -0,0 +1,1546 @@
+#pragma once
+
+// An Itanium C++ ABI demangler that never allocates.
+//
+// abi::__cxa_demangle mallocs its result and its working state on every
+// call. This one builds its syntax tree in a fixed arena inside the
+// Demangler object and prints straight into a buffer the caller provides:
+//
+//   char buf[256];
+//   demangle(typeid(DynamicArray<TypedClass<double>>).name(), buf, sizeof buf);
+//   // buf: "DynamicArray<TypedClass<double, VerbosePolicy> >"
+//
+// A Demangler is about 70KB, too big for the stack of whoever calls the free
+// function: that one uses a thread_local Demangler, constant-initialized so
+// that it's zero-filled TLS, set up with the thread and never allocated.
+// Separate Demangler objects share nothing, which makes one per thread
+// enough for thread safety.
+//
+// Output matches __cxa_demangle for what it understands: types, functions,
+// templates (including packs and literal arguments), operators, ctors and
+// dtors, local names, lambdas, ABI tags, the T and G special names and
+// clone suffixes. Expressions in template arguments, decltype and vector
+// types are not supported and report InvalidName.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <typeinfo>
+
+enum class DemangleStatus {
+  Ok,
+  BufferTooSmall, // the output was cut short (still NUL-terminated)
+  InvalidName,    // not a mangled name, or uses an unsupported feature
+  TooComplex,     // ran out of arena space or nesting depth
+};
+
+struct DemangleResult {
+  DemangleStatus status;
+  size_t length; // characters written, excluding the NUL
+
+  explicit operator bool() const { return status == DemangleStatus::Ok; }
+};
+
+class Demangler {
+public:
+  static constexpr size_t kMaxNodes = 1024;
+  static constexpr size_t kMaxListItems = 1024;
+  static constexpr size_t kMaxSubstitutions = 256;
+  static constexpr unsigned kMaxDepth = 256;
+
+  Demangler() = default;
+  // Zero-fills the arena too, which makes the constructor constant: for a
+  // static or thread_local Demangler that lives in .tbss and costs nothing
+  struct ZeroFill {};
+  explicit constexpr Demangler(ZeroFill)
+      : nodes{}, items{}, scratch{}, subs{}, subParams{} {}
+
+  // Demangles `mangled` into out[0, cap). Accepts symbols (_Z...) as well as
+  // bare type names as returned by std::type_info::name().
+  DemangleResult demangle(std::string_view mangled, char *out, size_t cap) {
+    reset(mangled);
+    const Node *n = parseTop();
+    if (!n || failed)
+      return finish(out, cap, 0);
+    outBuf = out;
+    outCap = cap ? cap - 1 : 0; // room for the NUL
+    outLen = 0;
+    print(n);
+    return finish(out, cap, outLen);
+  }
+
+private:
+  enum class Kind : uint8_t {
+    Name,          // text
+    Nested,        // a::b
+    Template,      // a<list>
+    ArgPack,       // list, a template parameter pack
+    PackExpansion, // a...
+    Qual,          // a cv
+    Pointer,       // a*
+    LRef,          // a&
+    RRef,          // a&&
+    Function,      // a (list) cv ref
+    Array,         // a [text]
+    MemberPointer, // b a::*
+    Encoding,      // a b(list) cv ref
+    Ctor,          // a
+    Dtor,          // ~a
+    Conversion,    // operator a
+    AbiTag,        // a[abi:text]
+    Closure,       // {lambda(list)#num}
+    Unnamed,       // {unnamed type#num}
+    DefaultArg,    // {default arg#num}
+    AutoParam,     // auto:num, a generic lambda's parameter
+    Local,         // a::b
+    Literal,       // (a)text
+    Special,       // text a
+    CtorVtable,    // construction vtable for b-in-a
+    Clone,         // a [clone text]
+  };
+
+  enum : uint8_t { Const = 1, Volatile = 2, Restrict = 4 };
+
+  // No member initializers: the arena stays uninitialized until make()
+  // hands a node out, so constructing a Demangler costs nothing
+  struct Node {
+    Kind kind;
+    uint8_t cv;
+    uint8_t ref; // 1 for &, 2 for &&
+    bool negative;
+    uint16_t first; // list: items[first, first + count)
+    uint16_t count;
+    uint32_t num;
+    std::string_view text;
+    const Node *a;
+    const Node *b;
+  };
+
+  // What parseName found out about an encoding's name
+  struct NameInfo {
+    bool templated = false;    // ends in template arguments
+    bool ctorDtorConv = false; // ...of a ctor, dtor or conversion operator
+    uint8_t cv = 0;
+    uint8_t ref = 0;
+  };
+
+  std::string_view in;
+  size_t pos = 0;
+  bool failed = false;
+  bool tooComplex = false;
+  unsigned depth = 0;
+
+  Node nodes[kMaxNodes];
+  size_t nodeCount = 0;
+  const Node *items[kMaxListItems];
+  size_t itemCount = 0;
+  const Node *scratch[kMaxListItems]; // lists under construction
+  size_t scratchTop = 0;
+  const Node *subs[kMaxSubstitutions];
+  // For a substitution that is a template param, its index, else kNoParam
+  size_t subParams[kMaxSubstitutions];
+  size_t subCount = 0;
+  size_t lastParam = 0; // the index parseTemplateParam() last resolved
+  const Node *params = nullptr; // the template args T_, T0_, ... refer to
+  const Node *lastName = nullptr; // for ctor and dtor names
+  bool inLambdaSig = false;       // template params there are auto params
+
+  char *outBuf = nullptr;
+  size_t outCap = 0;
+  size_t outLen = 0;
+  char lastChar = 0;
+  const Node *pack = nullptr; // being expanded, currently its element packIndex
+  int packIndex = 0;
+  bool inClosure = false;
+
+  void reset(std::string_view s) {
+    in = s;
+    pos = 0;
+    failed = tooComplex = false;
+    depth = 0;
+    nodeCount = itemCount = scratchTop = subCount = 0;
+    params = nullptr;
+    lastName = nullptr;
+    inLambdaSig = false;
+    lastChar = 0;
+    pack = nullptr;
+    inClosure = false;
+  }
+
+  DemangleResult finish(char *out, size_t cap, size_t len) {
+    if (cap)
+      out[len < cap ? len : cap - 1] = '\0';
+    if (tooComplex)
+      return {DemangleStatus::TooComplex, 0};
+    if (failed)
+      return {DemangleStatus::InvalidName, 0};
+    if (outLen > outCap)
+      return {DemangleStatus::BufferTooSmall, outCap};
+    return {DemangleStatus::Ok, len};
+  }
+
+  // ---- Arena ----
+
+  Node *make(Kind k, const Node *a = nullptr, const Node *b = nullptr) {
+    if (nodeCount == kMaxNodes) {
+      tooComplex = failed = true;
+      return nullptr;
+    }
+    Node *n = &nodes[nodeCount++];
+    *n = Node{};
+    n->kind = k;
+    n->a = a;
+    n->b = b;
+    return n;
+  }
+  Node *makeName(std::string_view text) {
+    Node *n = make(Kind::Name);
+    if (n)
+      n->text = text;
+    return n;
+  }
+
+  bool pushScratch(const Node *n) {
+    if (scratchTop == kMaxListItems) {
+      tooComplex = failed = true;
+      return false;
+    }
+    scratch[scratchTop++] = n;
+    return true;
+  }
+  // Moves scratch[base, top) into the list storage of n
+  bool commitList(Node *n, size_t base) {
+    size_t count = scratchTop - base;
+    if (itemCount + count > kMaxListItems) {
+      tooComplex = failed = true;
+      return false;
+    }
+    std::memcpy(items + itemCount, scratch + base, count * sizeof(Node *));
+    n->first = static_cast<uint16_t>(itemCount);
+    n->count = static_cast<uint16_t>(count);
+    itemCount += count;
+    scratchTop = base;
+    return true;
+  }
+
+  static constexpr size_t kNoParam = SIZE_MAX;
+  void addSubstitution(const Node *n, size_t param = kNoParam) {
+    if (subCount == kMaxSubstitutions) {
+      tooComplex = failed = true;
+      return;
+    }
+    subParams[subCount] = param;
+    subs[subCount++] = n;
+  }
+
+  // ---- Input ----
+
+  char peek(size_t ahead = 0) const {
+    return pos + ahead < in.size() ? in[pos + ahead] : '\0';
+  }
+  bool consume(char c) {
+    if (peek() != c)
+      return false;
+    ++pos;
+    return true;
+  }
+  bool consume(std::string_view s) {
+    if (in.substr(pos, s.size()) != s)
+      return false;
+    pos += s.size();
+    return true;
+  }
+  bool atEnd() const { return pos >= in.size(); }
+  std::nullptr_t fail() {
+    failed = true;
+    return nullptr;
+  }
+
+  static bool isDigit(char c) { return c >= '0' && c <= '9'; }
+  static bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+  static bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+
+  // <number> ::= [n] <decimal>; returns the digits, sets negative
+  std::string_view parseNumber(bool *negative = nullptr) {
+    bool neg = consume('n');
+    if (negative)
+      *negative = neg;
+    size_t start = pos;
+    while (isDigit(peek()))
+      ++pos;
+    return in.substr(start, pos - start);
+  }
+  bool parseCount(size_t &value) {
+    std::string_view digits = parseNumber();
+    if (digits.empty() || digits.size() > 9)
+      return false;
+    value = 0;
+    for (char c : digits)
+      value = value * 10 + size_t(c - '0');
+    return true;
+  }
+  // <seq-id> in base 36, then '_'; returns 0 for a bare '_', seq-id + 1 else
+  bool parseSeqId(size_t &value) {
+    value = 0;
+    if (consume('_'))
+      return true;
+    size_t v = 0;
+    while (isDigit(peek()) || isUpper(peek())) {
+      char c = in[pos++];
+      v = v * 36 + size_t(isDigit(c) ? c - '0' : c - 'A' + 10);
+      if (v > 1u << 20)
+        return false;
+    }
+    value = v + 1;
+    return consume('_');
+  }
+  // _ <digit> | __ <number> _
+  void skipDiscriminator() {
+    if (peek() != '_')
+      return;
+    if (isDigit(peek(1))) {
+      pos += 2;
+    } else if (peek(1) == '_') {
+      size_t save = pos;
+      pos += 2;
+      size_t n;
+      if (!parseCount(n) || !consume('_'))
+        pos = save;
+    }
+  }
+  uint8_t parseCV() {
+    uint8_t cv = 0;
+    if (consume('r'))
+      cv |= Restrict;
+    if (consume('V'))
+      cv |= Volatile;
+    if (consume('K'))
+      cv |= Const;
+    return cv;
+  }
+
+  struct DepthGuard {
+    Demangler &d;
+    bool ok;
+    explicit DepthGuard(Demangler &d) : d(d), ok(++d.depth <= kMaxDepth) {
+      if (!ok)
+        d.tooComplex = d.failed = true;
+    }
+    ~DepthGuard() { --d.depth; }
+  };
+
+  // ---- Parser ----
+
+  const Node *parseTop() {
+    if (consume("_Z")) {
+      const Node *n = parseEncoding();
+      // GCC clones: foo.constprop.0, foo.isra.0, foo.part.1.lto_priv.0
+      while (n && peek() == '.' &&
+             (isLower(peek(1)) || isDigit(peek(1)) || peek(1) == '_')) {
+        size_t start = pos;
+        pos += 2;
+        while (isLower(peek()) || peek() == '_')
+          ++pos;
+        while (peek() == '.' && isDigit(peek(1))) {
+          pos += 2;
+          while (isDigit(peek()))
+            ++pos;
+        }
+        Node *c = make(Kind::Clone, n);
+        if (c)
+          c->text = in.substr(start, pos - start);
+        n = c;
+      }
+      return atEnd() ? n : fail();
+    }
+    const Node *t = parseType();
+    return atEnd() ? t : fail();
+  }
+
+  bool atEncodingEnd() const {
+    return atEnd() || peek() == 'E' || peek() == '.';
+  }
+
+  const Node *parseEncoding() {
+    DepthGuard g(*this);
+    if (!g.ok)
+      return nullptr;
+    if (peek() == 'T' || peek() == 'G')
+      return parseSpecialName();
+
+    NameInfo info;
+    const Node *name = parseName(&info);
+    if (!name)
+      return nullptr;
+    if (atEncodingEnd())
+      return name;
+
+    const Node *ret = nullptr;
+    if (info.templated && !info.ctorDtorConv && !(ret = parseType()))
+      return nullptr;
+    Node *enc = make(Kind::Encoding, ret, name);
+    if (!enc)
+      return nullptr;
+    enc->cv = info.cv;
+    enc->ref = info.ref;
+    if (peek() == 'v' && (pos + 1 == in.size() || in[pos + 1] == 'E' ||
+                          in[pos + 1] == '.')) {
+      ++pos;
+      return commitList(enc, scratchTop) ? enc : nullptr;
+    }
+    size_t base = scratchTop;
+    while (!atEncodingEnd()) {
+      const Node *p = parseType();
+      if (!p || !pushScratch(p))
+        return nullptr;
+    }
+    return commitList(enc, base) ? enc : nullptr;
+  }
+
+  // Name of the thing a special name is for: a type or an encoding
+  const Node *special(std::string_view text, const Node *of) {
+    if (!of)
+      return nullptr;
+    Node *n = make(Kind::Special, of);
+    if (n)
+      n->text = text;
+    return n;
+  }
+  bool parseCallOffset() {
+    if (consume('h'))
+      return (parseNumber(), consume('_'));
+    if (consume('v'))
+      return (parseNumber(), consume('_')) && (parseNumber(), consume('_'));
+    return false;
+  }
+
+  const Node *parseSpecialName() {
+    if (consume('T')) {
+      char c = peek();
+      ++pos;
+      switch (c) {
+      case 'V':
+        return special("vtable for ", parseType());
+      case 'T':
+        return special("VTT for ", parseType());
+      case 'I':
+        return special("typeinfo for ", parseType());
+      case 'S':
+        return special("typeinfo name for ", parseType());
+      case 'h':
+      case 'v':
+        --pos;
+        if (!parseCallOffset())
+          return fail();
+        return special(c == 'h' ? "non-virtual thunk to " : "virtual thunk to ",
+                       parseEncoding());
+      case 'c':
+        if (!parseCallOffset() || !parseCallOffset())
+          return fail();
+        return special("covariant return thunk to ", parseEncoding());
+      case 'C': {
+        const Node *derived = parseType();
+        if (!derived)
+          return nullptr;
+        parseNumber();
+        if (!consume('_'))
+          return fail();
+        const Node *base = parseType();
+        return base ? make(Kind::CtorVtable, derived, base) : nullptr;
+      }
+      case 'H':
+        return special("TLS init function for ", parseName(nullptr));
+      case 'W':
+        return special("TLS wrapper function for ", parseName(nullptr));
+      }
+      return fail();
+    }
+    if (consume("GTt"))
+      return special("transaction clone for ", parseEncoding());
+    if (consume("GV"))
+      return special("guard variable for ", parseName(nullptr));
+    if (consume("GR")) {
+      const Node *of = parseName(nullptr);
+      size_t seq;
+      if (!of || !parseSeqId(seq))
+        return fail();
+      Node *n = make(Kind::Special, of);
+      if (n) {
+        n->text = "reference temporary #";
+        n->num = uint32_t(seq);
+      }
+      return n;
+    }
+    return fail();
+  }
+
+  const Node *parseName(NameInfo *info) {
+    DepthGuard g(*this);
+    if (!g.ok)
+      return nullptr;
+    switch (peek()) {
+    case 'N':
+      return parseNestedName(info);
+    case 'Z':
+      return parseLocalName(info);
+    case 'S':
+      if (peek(1) != 't') {
+        const Node *sub = parseSubstitution(false);
+        if (!sub || peek() != 'I')
+          return fail();
+        const Node *args = parseTemplateArgs(info != nullptr);
+        if (info)
+          info->templated = true;
+        return args ? make(Kind::Template, sub, args) : nullptr;
+      }
+      break;
+    }
+
+    bool inStd = consume("St");
+    const Node *n = parseUnqualifiedName(info);
+    if (n && inStd) {
+      const Node *std = makeName("std");
+      n = std ? make(Kind::Nested, std, n) : nullptr;
+    }
+    if (n && peek() == 'I') {
+      addSubstitution(n);
+      const Node *args = parseTemplateArgs(info != nullptr);
+      if (info)
+        info->templated = true;
+      n = args ? make(Kind::Template, n, args) : nullptr;
+    }
+    return n;
+  }
+
+  const Node *parseNestedName(NameInfo *info) {
+    if (!consume('N'))
+      return fail();
+    uint8_t cv = parseCV();
+    uint8_t ref = consume('R') ? 1 : consume('O') ? 2 : 0;
+    if (info) {
+      info->cv = cv;
+      info->ref = ref;
+    }
+
+    const Node *soFar = nullptr;
+    size_t param = kNoParam; // soFar is template param `param`
+    while (!consume('E')) {
+      if (atEnd())
+        return fail();
+      char c = peek();
+      if (c == 'S' && peek(1) == 't') {
+        if (soFar)
+          return fail();
+        pos += 2;
+        soFar = makeName("std");
+        continue; // "std" alone is not a substitution candidate
+      } else if (c == 'S') {
+        if (soFar)
+          return fail();
+        soFar = parseSubstitution(true);
+        if (!soFar)
+          return nullptr;
+        continue;
+      } else if (c == 'I') {
+        if (!soFar)
+          return fail();
+        const Node *args = parseTemplateArgs(info != nullptr);
+        soFar = args ? make(Kind::Template, soFar, args) : nullptr;
+        if (info)
+          info->templated = true;
+      } else if (c == 'T') {
+        if (soFar)
+          return fail();
+        soFar = parseTemplateParam();
+        param = inLambdaSig ? kNoParam : lastParam;
+      } else if (c == 'D' && (peek(1) == 't' || peek(1) == 'T')) {
+        return fail(); // decltype
+      } else {
+        const Node *comp = parseUnqualifiedName(info);
+        if (!comp)
+          return nullptr;
+        soFar = soFar ? make(Kind::Nested, soFar, comp) : comp;
+        if (info)
+          info->templated = false;
+      }
+      if (!soFar)
+        return nullptr;
+      if (peek() != 'E')
+        addSubstitution(soFar, param);
+      param = kNoParam;
+    }
+    return soFar ? soFar : fail();
+  }
+
+  const Node *parseLocalName(NameInfo *info) {
+    if (!consume('Z'))
+      return fail();
+    // Unless this names the function being demangled, the enclosing
+    // function's template args stop applying once we're past it
+    struct RestoreParams {
+      const Node *&params, *saved;
+      bool active;
+      ~RestoreParams() {
+        if (active)
+          params = saved;
+      }
+    } restore{params, params, info == nullptr};
+    const Node *encoding = parseEncoding();
+    if (!encoding || !consume('E'))
+      return fail();
+    if (consume('s')) {
+      skipDiscriminator();
+      const Node *lit = makeName("string literal");
+      return lit ? make(Kind::Local, encoding, lit) : nullptr;
+    }
+    const Node *scope = encoding;
+    if (consume('d')) { // default argument: Z <encoding> Ed [<number>] _ <name>
+      bool numbered = isDigit(peek());
+      size_t num = 0;
+      if ((numbered && !parseCount(num)) || !consume('_'))
+        return fail();
+      Node *arg = make(Kind::DefaultArg);
+      if (!arg)
+        return nullptr;
+      arg->num = uint32_t(numbered ? num + 2 : 1);
+      scope = make(Kind::Local, encoding, arg);
+    }
+    const Node *entity = parseName(info);
+    if (!entity || !scope)
+      return nullptr;
+    skipDiscriminator();
+    return make(Kind::Local, scope, entity);
+  }
+
+  const Node *parseSourceName() {
+    size_t len;
+    if (!parseCount(len) || len == 0 || len > in.size() - pos)
+      return fail();
+    std::string_view id = in.substr(pos, len);
+    pos += len;
+    Node *n = makeName(id.starts_with("_GLOBAL__N") ? "(anonymous namespace)"
+                                                    : id);
+    lastName = n;
+    return n;
+  }
+
+  struct Operator {
+    char code[3];
+    const char *name;
+  };
+  static const char *operatorName(char a, char b) {
+    static constexpr Operator ops[] = {
+        {"nw", "operator new"},     {"na", "operator new[]"},
+        {"dl", "operator delete"},  {"da", "operator delete[]"},
+        {"ps", "operator+"},        {"ng", "operator-"},
+        {"ad", "operator&"},        {"de", "operator*"},
+        {"co", "operator~"},        {"pl", "operator+"},
+        {"mi", "operator-"},        {"ml", "operator*"},
+        {"dv", "operator/"},        {"rm", "operator%"},
+        {"an", "operator&"},        {"or", "operator|"},
+        {"eo", "operator^"},        {"aS", "operator="},
+        {"pL", "operator+="},       {"mI", "operator-="},
+        {"mL", "operator*="},       {"dV", "operator/="},
+        {"rM", "operator%="},       {"aN", "operator&="},
+        {"oR", "operator|="},       {"eO", "operator^="},
+        {"ls", "operator<<"},       {"rs", "operator>>"},
+        {"lS", "operator<<="},      {"rS", "operator>>="},
+        {"eq", "operator=="},       {"ne", "operator!="},
+        {"lt", "operator<"},        {"gt", "operator>"},
+        {"le", "operator<="},       {"ge", "operator>="},
+        {"ss", "operator<=>"},      {"nt", "operator!"},
+        {"aa", "operator&&"},       {"oo", "operator||"},
+        {"pp", "operator++"},       {"mm", "operator--"},
+        {"cm", "operator,"},        {"pm", "operator->*"},
+        {"pt", "operator->"},       {"cl", "operator()"},
+        {"ix", "operator[]"},       {"qu", "operator?"},
+        {"st", "operator sizeof "}, {"sz", "operator sizeof "},
+        {"at", "operator alignof "}, {"az", "operator alignof "},
+        {"aw", "operator co_await"},
+    };
+    for (const Operator &op : ops)
+      if (op.code[0] == a && op.code[1] == b)
+        return op.name;
+    return nullptr;
+  }
+
+  const Node *parseUnqualifiedName(NameInfo *info) {
+    if (info)
+      info->ctorDtorConv = false;
+    const Node *n = nullptr;
+    char c = peek();
+    if (isDigit(c)) {
+      n = parseSourceName();
+    } else if (c == 'L') { // internal linkage
+      ++pos;
+      n = parseSourceName();
+      skipDiscriminator();
+    } else if (c == 'C' && (isDigit(peek(1)) || peek(1) == 'I')) {
+      pos += 1;
+      bool inheriting = consume('I');
+      if (!isDigit(peek()) || !lastName)
+        return fail();
+      ++pos;
+      if (inheriting && !parseType())
+        return nullptr;
+      n = make(Kind::Ctor, lastName);
+      if (info)
+        info->ctorDtorConv = true;
+    } else if (c == 'D' && isDigit(peek(1))) {
+      pos += 2;
+      if (!lastName)
+        return fail();
+      n = make(Kind::Dtor, lastName);
+      if (info)
+        info->ctorDtorConv = true;
+    } else if (c == 'U' && peek(1) == 't') {
+      pos += 2;
+      bool numbered = isDigit(peek());
+      size_t num = 0;
+      if ((numbered && !parseCount(num)) || !consume('_'))
+        return fail();
+      Node *u = make(Kind::Unnamed);
+      if (u)
+        u->num = uint32_t(numbered ? num + 2 : 1);
+      n = u;
+    } else if (c == 'U' && peek(1) == 'l') {
+      n = parseClosure();
+    } else if (c == 'c' && peek(1) == 'v') {
+      pos += 2;
+      const Node *to = parseType();
+      n = to ? make(Kind::Conversion, to) : nullptr;
+      if (info)
+        info->ctorDtorConv = true;
+    } else if (c == 'l' && peek(1) == 'i') { // operator "" _suffix
+      pos += 2;
+      n = special("operator\"\" ", parseSourceName());
+    } else if (const char *op = isLower(c) ? operatorName(c, peek(1)) : nullptr) {
+      pos += 2;
+      n = makeName(op);
+    } else {
+      return fail();
+    }
+
+    while (n && consume('B')) {
+      size_t len;
+      if (!parseCount(len) || len == 0 || len > in.size() - pos)
+        return fail();
+      Node *tag = make(Kind::AbiTag, n);
+      if (tag)
+        tag->text = in.substr(pos, len);
+      pos += len;
+      n = tag;
+    }
+    return n;
+  }
+
+  // Ul <lambda-sig> E [<number>] _
+  const Node *parseClosure() {
+    pos += 2;
+    Node *n = make(Kind::Closure);
+    if (!n)
+      return nullptr;
+    size_t base = scratchTop;
+    if (peek() == 'v' && peek(1) == 'E') {
+      ++pos;
+    } else {
+      bool saved = inLambdaSig;
+      inLambdaSig = true;
+      while (peek() != 'E') {
+        if (atEnd())
+          return fail();
+        const Node *p = parseType();
+        if (!p || !pushScratch(p))
+          return nullptr;
+      }
+      inLambdaSig = saved;
+    }
+    ++pos;
+    bool numbered = isDigit(peek());
+    size_t num = 0;
+    if ((numbered && !parseCount(num)) || !consume('_'))
+      return fail();
+    n->num = uint32_t(numbered ? num + 2 : 1);
+    return commitList(n, base) ? n : nullptr;
+  }
+
+  // S_, S<seq-id>_ and the std:: abbreviations. In a nested name's prefix
+  // (before a ctor or dtor) the std::string family prints in full.
+  const Node *parseSubstitution(bool inPrefix, bool underRef = false) {
+    if (!consume('S'))
+      return fail();
+    if (isLower(peek())) {
+      struct Abbrev {
+        char code;
+        const char *simple, *full, *last;
+      };
+      static constexpr Abbrev abbrevs[] = {
+          {'a', "std::allocator", "std::allocator", "allocator"},
+          {'b', "std::basic_string", "std::basic_string", "basic_string"},
+          {'s', "std::string",
+           "std::basic_string<char, std::char_traits<char>, "
+           "std::allocator<char> >",
+           "basic_string"},
+          {'i', "std::istream",
+           "std::basic_istream<char, std::char_traits<char> >",
+           "basic_istream"},
+          {'o', "std::ostream",
+           "std::basic_ostream<char, std::char_traits<char> >",
+           "basic_ostream"},
+          {'d', "std::iostream",
+           "std::basic_iostream<char, std::char_traits<char> >",
+           "basic_iostream"},
+      };
+      char c = in[pos++];
+      for (const Abbrev &ab : abbrevs)
+        if (ab.code == c) {
+          lastName = makeName(ab.last);
+          bool full = inPrefix && (peek() == 'C' || peek() == 'D');
+          return makeName(full ? ab.full : ab.simple);
+        }
+      return fail();
+    }
+    size_t seq;
+    if (!parseSeqId(seq) || seq >= subCount)
+      return fail();
+    // __cxa_demangle resolves a template param where it prints it, so T_
+    // from a local name's function, brought back by a substitution in the
+    // enclosing one, is the enclosing function's T_ there. Not right under a
+    // & or &&, though: for reference collapsing it resolves those where the
+    // param was first seen.
+    size_t idx = subParams[seq];
+    if (idx != kNoParam && !underRef && !inLambdaSig && params &&
+        idx < params->count)
+      return item(params, idx);
+    return subs[seq];
+  }
+
+  const Node *parseTemplateParam() {
+    if (!consume('T'))
+      return fail();
+    size_t idx;
+    if (!parseSeqId(idx))
+      return fail();
+    if (inLambdaSig) {
+      Node *n = make(Kind::AutoParam);
+      if (n)
+        n->num = uint32_t(idx + 1);
+      return n;
+    }
+    lastParam = idx;
+    return params && idx < params->count ? item(params, idx) : fail();
+  }
+
+  // I <template-arg>+ E. When tag is set these become the parameters T_,
+  // T0_, ... refer to.
+  const Node *parseTemplateArgs(bool tag) {
+    DepthGuard g(*this);
+    if (!g.ok || !consume('I'))
+      return fail();
+    const Node *savedLast = lastName;
+    Node *n = make(Kind::Template); // only its list is used
+    if (!n)
+      return nullptr;
+    size_t base = scratchTop;
+    while (!consume('E')) {
+      if (atEnd())
+        return fail();
+      const Node *arg = parseTemplateArg();
+      if (!arg || !pushScratch(arg))
+        return nullptr;
+    }
+    lastName = savedLast;
+    if (!commitList(n, base))
+      return nullptr;
+    if (tag)
+      params = n;
+    return n;
+  }
+
+  const Node *parseTemplateArg() {
+    switch (peek()) {
+    case 'L':
+      return parseLiteral();
+    case 'J': {
+      ++pos;
+      Node *pack = make(Kind::ArgPack);
+      if (!pack)
+        return nullptr;
+      size_t base = scratchTop;
+      while (!consume('E')) {
+        if (atEnd())
+          return fail();
+        const Node *arg = parseTemplateArg();
+        if (!arg || !pushScratch(arg))
+          return nullptr;
+      }
+      return commitList(pack, base) ? pack : nullptr;
+    }
+    case 'X': { // only the simplest expressions: a parameter or a literal
+      ++pos;
+      const Node *e = peek() == 'T'   ? parseTemplateParam()
+                      : peek() == 'L' ? parseLiteral()
+                                      : fail();
+      return e && consume('E') ? e : fail();
+    }
+    default:
+      return parseType();
+    }
+  }
+
+  // L <type> <value> E | L _Z <encoding> E
+  const Node *parseLiteral() {
+    if (!consume('L'))
+      return fail();
+    if (consume("_Z") || consume('Z')) {
+      const Node *e = parseEncoding();
+      return e && consume('E') ? e : fail();
+    }
+    const Node *type = parseType();
+    if (!type)
+      return nullptr;
+    Node *n = make(Kind::Literal, type);
+    if (!n)
+      return nullptr;
+    n->negative = consume('n');
+    size_t start = pos;
+    while (isDigit(peek()) || isLower(peek()))
+      ++pos;
+    n->text = in.substr(start, pos - start);
+    return consume('E') ? n : fail();
+  }
+
+  const Node *parseBuiltin() {
+    static constexpr const char *simple[26] = {
+        "signed char", "bool", "char", "double", "long double", "float",
+        "__float128", "unsigned char", "int", "unsigned int", nullptr,
+        "long", "unsigned long", "__int128", "unsigned __int128", nullptr,
+        nullptr, nullptr, "short", "unsigned short", nullptr, "void",
+        "wchar_t", "long long", "unsigned long long", "..."};
+    char c = peek();
+    if (isLower(c) && simple[c - 'a']) {
+      ++pos;
+      return makeName(simple[c - 'a']);
+    }
+    if (c != 'D')
+      return nullptr;
+    const char *name = nullptr;
+    switch (peek(1)) {
+    case 'a': name = "auto"; break;
+    case 'c': name = "decltype(auto)"; break;
+    case 'n': name = "decltype(nullptr)"; break;
+    case 'i': name = "char32_t"; break;
+    case 's': name = "char16_t"; break;
+    case 'u': name = "char8_t"; break;
+    case 'd': name = "decimal64"; break;
+    case 'e': name = "decimal128"; break;
+    case 'f': name = "decimal32"; break;
+    case 'h': name = "half"; break;
+    case 'F': { // DF <bits> _
+      pos += 2;
+      std::string_view bits = parseNumber();
+      if (bits.empty() || !consume('_'))
+        return fail();
+      return special("_Float", makeName(bits));
+    }
+    default:
+      return nullptr;
+    }
+    pos += 2;
+    return makeName(name);
+  }
+
+  const Node *parseFunctionType() {
+    if (!consume('F'))
+      return fail();
+    consume('Y'); // extern "C"
+    const Node *ret = parseType();
+    if (!ret)
+      return nullptr;
+    Node *fn = make(Kind::Function, ret);
+    if (!fn)
+      return nullptr;
+    size_t base = scratchTop;
+    if (peek() == 'v' && peek(1) == 'E') {
+      ++pos;
+    } else {
+      for (;;) {
+        if (peek() == 'E')
+          break;
+        if ((peek() == 'R' || peek() == 'O') && peek(1) == 'E') {
+          fn->ref = peek() == 'R' ? 1 : 2;
+          ++pos;
+          break;
+        }
+        if (atEnd())
+          return fail();
+        const Node *p = parseType();
+        if (!p || !pushScratch(p))
+          return nullptr;
+      }
+    }
+    ++pos;
+    return commitList(fn, base) ? fn : nullptr;
+  }
+
+  // underRef: the type an R or O applies to
+  const Node *parseType(bool underRef = false) {
+    DepthGuard g(*this);
+    if (!g.ok)
+      return nullptr;
+    if (const Node *b = parseBuiltin())
+      return b;
+    if (failed)
+      return nullptr;
+
+    const Node *t = nullptr;
+    size_t param = kNoParam; // t is template param `param`
+    switch (peek()) {
+    case 'r':
+    case 'V':
+    case 'K': {
+      uint8_t cv = parseCV();
+      const Node *inner = parseType();
+      if (!inner)
+        return nullptr;
+      Node *q;
+      if (inner->kind == Kind::Qual) { // T const, where T is already const
+        q = make(Kind::Qual, inner->a);
+        if (q)
+          q->cv = inner->cv | cv;
+      } else if (inner->kind == Kind::Function) {
+        // A member function's cv; unlike other qualified types this one is
+        // not a substitution candidate of its own
+        q = make(Kind::Function);
+        if (q) {
+          *q = *inner;
+          q->cv |= cv;
+        }
+        return q;
+      } else {
+        q = make(Kind::Qual, inner);
+        if (q)
+          q->cv = cv;
+      }
+      t = q;
+      break;
+    }
+    case 'P':
+    case 'R':
+    case 'O': {
+      char c = in[pos++];
+      const Node *inner = parseType(c != 'P');
+      if (!inner)
+        return nullptr;
+      t = make(c == 'P' ? Kind::Pointer : c == 'R' ? Kind::LRef : Kind::RRef,
+               inner);
+      break;
+    }
+    case 'F':
+      t = parseFunctionType();
+      break;
+    case 'A': {
+      ++pos;
+      std::string_view dim = parseNumber();
+      if (!consume('_'))
+        return fail();
+      const Node *elem = parseType();
+      Node *arr = elem ? make(Kind::Array, elem) : nullptr;
+      if (arr)
+        arr->text = dim;
+      t = arr;
+      break;
+    }
+    case 'M': {
+      ++pos;
+      const Node *cls = parseType();
+      const Node *member = cls ? parseType() : nullptr;
+      t = member ? make(Kind::MemberPointer, cls, member) : nullptr;
+      break;
+    }
+    case 'T':
+      if (peek(1) == 's' || peek(1) == 'u' || peek(1) == 'e') {
+        pos += 2;
+        t = parseName(nullptr);
+        break;
+      }
+      t = parseTemplateParam();
+      param = inLambdaSig ? kNoParam : lastParam;
+      if (t && peek() == 'I') { // template template parameter
+        addSubstitution(t, param);
+        param = kNoParam;
+        const Node *args = parseTemplateArgs(false);
+        t = args ? make(Kind::Template, t, args) : nullptr;
+      }
+      break;
+    case 'D':
+      if (peek(1) == 'p') {
+        pos += 2;
+        const Node *pattern = parseType();
+        t = pattern ? make(Kind::PackExpansion, pattern) : nullptr;
+        break;
+      }
+      return fail(); // decltype, vector types
+    case 'u': { // vendor extended type
+      ++pos;
+      t = parseSourceName();
+      break;
+    }
+    case 'S':
+      if (peek(1) != 't') {
+        const Node *sub = parseSubstitution(false, underRef);
+        if (!sub || peek() != 'I')
+          return sub;
+        const Node *args = parseTemplateArgs(false);
+        t = args ? make(Kind::Template, sub, args) : nullptr;
+        break;
+      }
+      t = parseName(nullptr);
+      break;
+    case 'N':
+    case 'Z':
+      t = parseName(nullptr);
+      break;
+    default:
+      if (!isDigit(peek()))
+        return fail();
+      t = parseName(nullptr);
+      break;
+    }
+    if (!t)
+      return fail();
+    addSubstitution(t, param);
+    return t;
+  }
+
+  // ---- Printer ----
+
+  void put(char c) {
+    if (outLen < outCap)
+      outBuf[outLen] = c;
+    ++outLen;
+    lastChar = c;
+  }
+  void put(std::string_view s) {
+    if (s.empty())
+      return;
+    if (outLen < outCap)
+      std::memcpy(outBuf + outLen, s.data(),
+                  s.size() < outCap - outLen ? s.size() : outCap - outLen);
+    outLen += s.size();
+    lastChar = s.back();
+  }
+  void putNumber(uint32_t v) {
+    char digits[10];
+    int n = 0;
+    do
+      digits[n++] = char('0' + v % 10);
+    while (v /= 10);
+    while (n)
+      put(digits[--n]);
+  }
+  void putCV(uint8_t cv) {
+    if (cv & Const)
+      put(" const");
+    if (cv & Volatile)
+      put(" volatile");
+    if (cv & Restrict)
+      put(" restrict");
+  }
+  void putRef(uint8_t ref) {
+    if (ref)
+      put(ref == 1 ? " &" : " &&");
+  }
+  bool full() const { return outLen > outCap; }
+
+  const Node *item(const Node *list, size_t i) const {
+    return items[list->first + i];
+  }
+
+  // The pack an expansion expands: the first one reachable from n
+  const Node *findPack(const Node *n) const {
+    if (!n || n->kind == Kind::PackExpansion)
+      return nullptr;
+    if (n->kind == Kind::ArgPack)
+      return n;
+    if (const Node *p = findPack(n->a))
+      return p;
+    if (const Node *p = findPack(n->b))
+      return p;
+    if (n->kind != Kind::Name && n->kind != Kind::Literal)
+      for (size_t i = 0; i < n->count; ++i)
+        if (const Node *p = findPack(item(n, i)))
+          return p;
+    return nullptr;
+  }
+  // An ArgPack, or an expansion of one, with nothing in it
+  bool printsNothing(const Node *n) const {
+    if (n->kind == Kind::ArgPack && n != pack) {
+      for (size_t i = 0; i < n->count; ++i)
+        if (!printsNothing(item(n, i)))
+          return false;
+      return true;
+    }
+    if (n->kind == Kind::PackExpansion) {
+      const Node *p = findPack(n->a);
+      return p && p->count == 0;
+    }
+    return false;
+  }
+
+  // __cxa_demangle prints a separator before the rest of a list, and takes
+  // it back if the rest printed nothing. So an empty pack prints "A<B, , C>"
+  // in the middle of a list but nothing at its end, where it leaves "A<B<C>>"
+  // without the usual space between the '>'s.
+  void printList(const Node *list) {
+    for (size_t i = 0; i < list->count && !full(); ++i) {
+      if (i) {
+        size_t j = i;
+        while (j < list->count && printsNothing(item(list, j)))
+          ++j;
+        if (j == list->count) {
+          lastChar = ' ';
+          return;
+        }
+        put(", ");
+      }
+      print(item(list, i));
+    }
+  }
+
+  bool hasArray(const Node *n) const {
+    n = resolvePack(n);
+    return n->kind == Kind::Array || (n->kind == Kind::Qual && hasArray(n->a));
+  }
+  bool hasFunction(const Node *n) const {
+    return resolvePack(n)->kind == Kind::Function;
+  }
+  // A pointer, reference or member pointer to an array or function, whose
+  // left part ends in "(*" and takes no space after it
+  bool opensParen(const Node *n) const {
+    n = resolvePack(n);
+    if (n->kind == Kind::Pointer || n->kind == Kind::LRef ||
+        n->kind == Kind::RRef) {
+      Kind k;
+      const Node *to = pointee(n, k);
+      return hasArray(to) || hasFunction(to);
+    }
+    return n->kind == Kind::MemberPointer &&
+           (hasArray(n->b) || hasFunction(n->b));
+  }
+
+  const Node *resolvePack(const Node *n) const {
+    if (n == pack)
+      return item(n, size_t(packIndex));
+    return n;
+  }
+
+  // What a pointer or reference n points to. References to references
+  // collapse (T& && is T&), which `kind` reflects.
+  const Node *pointee(const Node *n, Kind &kind) const {
+    kind = n->kind;
+    const Node *to = resolvePack(n->a);
+    while (kind != Kind::Pointer &&
+           (to->kind == Kind::LRef || to->kind == Kind::RRef)) {
+      if (to->kind == Kind::LRef)
+        kind = Kind::LRef;
+      to = resolvePack(to->a);
+    }
+    return to;
+  }
+
+  void print(const Node *n) {
+    DepthGuard g(*this);
+    if (!g.ok || full())
+      return;
+    printLeft(n);
+    printRight(n);
+  }
+
+  void printLeft(const Node *n) {
+    DepthGuard g(*this);
+    if (!g.ok || full())
+      return;
+    n = resolvePack(n);
+    switch (n->kind) {
+    case Kind::Name:
+      put(n->text);
+      break;
+    case Kind::Nested:
+      print(n->a);
+      put("::");
+      print(n->b);
+      break;
+    case Kind::Local: // the enclosing function prints without return type
+      if (n->a->kind == Kind::Encoding)
+        printEncoding(n->a, false);
+      else
+        print(n->a);
+      put("::");
+      print(n->b);
+      break;
+    case Kind::Template:
+      print(n->a);
+      if (lastChar == '<')
+        put(' ');
+      put('<');
+      printList(n->b);
+      if (lastChar == '>')
+        put(' ');
+      put('>');
+      break;
+    case Kind::ArgPack:
+      printList(n);
+      break;
+    case Kind::PackExpansion: {
+      const Node *expanded = findPack(n->a);
+      if (!expanded) {
+        print(n->a);
+        put("...");
+        break;
+      }
+      const Node *savedPack = pack;
+      int savedIndex = packIndex;
+      pack = expanded;
+      for (int i = 0; i < expanded->count && !full(); ++i) {
+        if (i)
+          put(", ");
+        packIndex = i;
+        print(n->a);
+      }
+      pack = savedPack;
+      packIndex = savedIndex;
+      break;
+    }
+    case Kind::Qual:
+      printLeft(n->a);
+      putCV(n->cv);
+      break;
+    case Kind::Pointer:
+    case Kind::LRef:
+    case Kind::RRef: {
+      Kind k;
+      const Node *to = pointee(n, k);
+      printLeft(to);
+      if (hasArray(to))
+        put(' ');
+      if (hasArray(to) || hasFunction(to))
+        put('(');
+      put(k == Kind::Pointer ? "*" : k == Kind::LRef ? "&" : "&&");
+      break;
+    }
+    case Kind::Function:
+      printLeft(n->a);
+      if (!opensParen(n->a))
+        put(' ');
+      break;
+    case Kind::Array:
+      printLeft(n->a);
+      break;
+    case Kind::MemberPointer: {
+      const Node *member = resolvePack(n->b);
+      printLeft(member);
+      if (hasArray(member) || hasFunction(member))
+        put('(');
+      else
+        put(' ');
+      print(n->a);
+      put("::*");
+      break;
+    }
+    case Kind::Encoding:
+      printEncoding(n, true);
+      break;
+    case Kind::Ctor:
+      print(n->a);
+      break;
+    case Kind::Dtor:
+      put('~');
+      print(n->a);
+      break;
+    case Kind::Conversion:
+      put("operator ");
+      print(n->a);
+      break;
+    case Kind::AbiTag:
+      print(n->a);
+      put("[abi:");
+      put(n->text);
+      put(']');
+      break;
+    case Kind::Closure: {
+      put("{lambda(");
+      bool saved = inClosure;
+      inClosure = true;
+      printList(n);
+      inClosure = saved;
+      put(")#");
+      putNumber(n->num);
+      put('}');
+      break;
+    }
+    case Kind::Unnamed:
+      put("{unnamed type#");
+      putNumber(n->num);
+      put('}');
+      break;
+    case Kind::DefaultArg:
+      put("{default arg#");
+      putNumber(n->num);
+      put('}');
+      break;
+    case Kind::AutoParam:
+      // Outside the lambda's own signature (when a substitution refers
+      // back to it) this is the enclosing template's parameter
+      if (!inClosure && params && n->num <= params->count) {
+        print(item(params, n->num - 1));
+        break;
+      }
+      put("auto:");
+      putNumber(n->num);
+      break;
+    case Kind::Literal:
+      printLiteral(n);
+      break;
+    case Kind::Special:
+      put(n->text);
+      if (n->num || n->text.back() == '#') {
+        putNumber(n->num);
+        put(" for ");
+      }
+      print(n->a);
+      break;
+    case Kind::CtorVtable:
+      put("construction vtable for ");
+      print(n->b);
+      put("-in-");
+      print(n->a);
+      break;
+    case Kind::Clone:
+      print(n->a);
+      put(" [clone ");
+      put(n->text);
+      put(']');
+      break;
+    }
+  }
+
+  void printRight(const Node *n) {
+    DepthGuard g(*this);
+    if (!g.ok || full())
+      return;
+    n = resolvePack(n);
+    switch (n->kind) {
+    case Kind::Qual:
+      printRight(n->a);
+      break;
+    case Kind::Pointer:
+    case Kind::LRef:
+    case Kind::RRef: {
+      Kind k;
+      const Node *to = pointee(n, k);
+      if (hasArray(to) || hasFunction(to))
+        put(')');
+      printRight(to);
+      break;
+    }
+    case Kind::Function:
+      put('(');
+      printList(n);
+      put(')');
+      printRight(n->a);
+      putCV(n->cv);
+      putRef(n->ref);
+      break;
+    case Kind::Array:
+      if (lastChar != ']')
+        put(' ');
+      put('[');
+      put(n->text);
+      put(']');
+      printRight(n->a);
+      break;
+    case Kind::MemberPointer: {
+      const Node *member = resolvePack(n->b);
+      if (hasArray(member) || hasFunction(member))
+        put(')');
+      printRight(member);
+      break;
+    }
+    default:
+      break;
+    }
+  }
+
+  void printEncoding(const Node *n, bool withReturn) {
+    const Node *ret = withReturn ? n->a : nullptr;
+    if (ret) {
+      printLeft(ret);
+      if (!opensParen(ret))
+        put(' ');
+    }
+    print(n->b);
+    put('(');
+    printList(n);
+    put(')');
+    if (ret)
+      printRight(ret);
+    putCV(n->cv);
+    putRef(n->ref);
+  }
+
+  void printLiteral(const Node *n) {
+    std::string_view type = n->a->kind == Kind::Name ? n->a->text : "";
+    const char *suffix = nullptr;
+    if (type == "int")
+      suffix = "";
+    else if (type == "unsigned int")
+      suffix = "u";
+    else if (type == "long")
+      suffix = "l";
+    else if (type == "unsigned long")
+      suffix = "ul";
+    else if (type == "long long")
+      suffix = "ll";
+    else if (type == "unsigned long long")
+      suffix = "ull";
+    else if (type == "bool" && !n->negative &&
+             (n->text == "0" || n->text == "1")) {
+      put(n->text == "0" ? "false" : "true");
+      return;
+    }
+    if (!suffix) {
+      put('(');
+      print(n->a);
+      put(')');
+    }
+    if (n->negative)
+      put('-');
+    put(n->text);
+    if (suffix)
+      put(suffix);
+  }
+};
+
+// One-off demangling with this thread's Demangler
+inline DemangleResult demangle(std::string_view mangled, char *out, size_t cap) {
+  static thread_local constinit Demangler d{Demangler::ZeroFill{}};
+  return d.demangle(mangled, out, cap);
+}
+
+// The demangled name of T, worked out once per type into static storage.
+// Falls back to the mangled name if it doesn't demangle into 512 bytes.
+template <class T> const char *typeName() {
+  static const struct Name {
+    char buf[512];
+    Name() {
+      const char *mangled = typeid(T).name();
+      if (!demangle(mangled, buf, sizeof buf)) {
+        std::strncpy(buf, mangled, sizeof buf - 1);
+        buf[sizeof buf - 1] = '\0';
+      }
+    }
+  } name;
+  return name.buf;
+}
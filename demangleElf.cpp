@@ -0,0 +1,83 @@
+// Demangles every symbol of an ELF file in parallel and reports how fast.
+//
+//   demangleElf [file] [-j threads] [--print] [--compare]
+//
+// With no file it reads itself. --print lists "mangled -> demangled" for
+// every C++ symbol; --compare also times abi::__cxa_demangle on one thread,
+// one symbol at a time, the way typeChecks.cpp-style inspection used to.
+
+#include "elfSymbols.hpp"
+#include "symbolDemangler.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <iostream>
+#include <string>
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+  const char *path = "/proc/self/exe";
+  unsigned threads = 0;
+  bool print = false, compare = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view a = argv[i];
+    if (a == "-j" && i + 1 < argc)
+      threads = static_cast<unsigned>(std::atoi(argv[++i]));
+    else if (a == "--print")
+      print = true;
+    else if (a == "--compare")
+      compare = true;
+    else if (!a.starts_with("-"))
+      path = argv[i];
+    else {
+      std::cerr << "usage: " << argv[0]
+                << " [file] [-j threads] [--print] [--compare]\n";
+      return 2;
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  ElfFile elf(path);
+  std::vector<std::string_view> symbols = elf.symbols();
+  if (!elf.ok()) {
+    std::cerr << elf.error() << '\n';
+    return 1;
+  }
+  double readTime = secondsSince(start);
+
+  StringInterner strings;
+  start = std::chrono::steady_clock::now();
+  DemangledSymbols out = demangleSymbols(symbols, strings, threads);
+  double demangleTime = secondsSince(start);
+
+  if (print)
+    for (size_t i = 0; i < symbols.size(); ++i)
+      if (out.names[i].data() != symbols[i].data())
+        std::cout << symbols[i] << " -> " << out.names[i] << '\n';
+
+  std::cout << path << ": " << symbols.size() << " symbols read in "
+            << readTime * 1e3 << " ms\n"
+            << "  " << out.demangled << " demangled, " << out.failed
+            << " failed, " << strings.size() << " distinct names ("
+            << strings.bytes() << " bytes)\n"
+            << "  " << demangleTime * 1e3 << " ms, "
+            << symbols.size() / demangleTime << " symbols/s\n";
+
+  if (compare) {
+    start = std::chrono::steady_clock::now();
+    for (std::string_view s : symbols) {
+      if (!s.starts_with("_Z"))
+        continue;
+      int status; // names in the string table are NUL-terminated already
+      std::free(abi::__cxa_demangle(s.data(), nullptr, nullptr, &status));
+    }
+    double cxaTime = secondsSince(start);
+    std::cout << "  __cxa_demangle: " << cxaTime * 1e3 << " ms, "
+              << symbols.size() / cxaTime << " symbols/s\n";
+  }
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include "containerStats.hpp"
+#include "demangle.hpp"
+#include "probes.hpp"
+#include "typedClass.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iostream>
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+// A wrapper around std::vector<T> with a few constructors.
+//
+// Buffer lifetime is visible to tracers through dynamicarray:* probes (see
+// probes.hpp), each with the array's address first:
+//   alloc(this, data, bytes)          a constructor or copy allocated
+//   grow(this, oldData, data, bytes)  push_back/emplace_back/reserve/copy
+//                                     assignment reallocated
+//   free(this, data, bytes)           the destructor, a move assignment or
+//                                     release() let go of the buffer
+// Changes made through getArr() bypass them. The same points keep the live
+// byte count of containerStats.hpp, when that is compiled in.
+//
+// Elements with a Relocation constructor (TypedClass has one) are moved
+// through it when the array grows, rather than by the vector: that keeps
+// per-element probes out of the relocation loop.
+//
+// Alloc is the vector's allocator; PooledDynamicArray (bufferPool.hpp)
+// recycles buffers through it, and BulkCopyDynamicArray (bulkCopy.hpp)
+// copies through it.
+template <class T, class Alloc = std::allocator<T>> class DynamicArray {
+  std::vector<T, Alloc> arr;
+
+public:
+  // Empty vector
+  constexpr DynamicArray() : arr() {}
+
+  // Constructs vector with 'sz' default-initialized Ts
+  constexpr DynamicArray(size_t sz) : arr(sz, T{}) { allocated(); }
+
+  // Constructs vector from an initializer list {a, b, c, ...}
+  constexpr DynamicArray(std::initializer_list<T> init) : arr(init) {
+    allocated();
+    if (std::is_constant_evaluated())
+      return;
+    std::cout << "Used initializer list in DynamicArray<" << typeName<T>()
+              << ">" << std::endl;
+  }
+
+  // Constructs vector with 'sz' copies of 'val'
+  constexpr DynamicArray(size_t sz, const T &val) : arr(sz, val) {
+    allocated();
+  }
+
+  // Spelled out only to fire the probes; they do what the defaults would
+  constexpr DynamicArray(const DynamicArray &o) : arr(copyOf(o.arr)) {
+    allocated();
+  }
+  constexpr DynamicArray(DynamicArray &&) noexcept = default;
+  constexpr DynamicArray &operator=(const DynamicArray &o) {
+    if (o.arr.size() > arr.capacity())
+      grow([&] { arr = o.arr; });
+    else
+      arr = o.arr;
+    return *this;
+  }
+  constexpr DynamicArray &operator=(DynamicArray &&o) noexcept {
+    if (&o != this) {
+      TRACE_PROBE(dynamicarray, free, this, arr.data(), bytes());
+      account(-std::ptrdiff_t(bytes()));
+    }
+    arr = std::move(o.arr);
+    return *this;
+  }
+  constexpr ~DynamicArray() {
+    TRACE_PROBE(dynamicarray, free, this, arr.data(), bytes());
+    account(-std::ptrdiff_t(bytes()));
+  }
+
+  // Hands the buffer over as the destructor would release it, leaving the
+  // array empty
+  constexpr std::vector<T, Alloc> release() {
+    TRACE_PROBE(dynamicarray, free, this, arr.data(), bytes());
+    account(-std::ptrdiff_t(bytes()));
+    return std::exchange(arr, std::vector<T, Alloc>());
+  }
+
+  // Getter
+  constexpr std::vector<T, Alloc> &getArr() { return arr; }
+  constexpr const std::vector<T, Alloc> &getArr() const { return arr; }
+
+  // Thin forwarders so callers don't have to reach through getArr()
+  constexpr size_t size() const { return arr.size(); }
+  constexpr bool empty() const { return arr.empty(); }
+  constexpr void reserve(size_t n) {
+    if (n > arr.capacity())
+      grow([&] { arr.reserve(n); }, n);
+  }
+  constexpr void push_back(const T &x) {
+    if (full())
+      grow([&] { arr.push_back(x); }, room(x));
+    else
+      arr.push_back(x);
+  }
+  constexpr void push_back(T &&x) {
+    if (full())
+      grow([&] { arr.push_back(std::move(x)); }, room(x));
+    else
+      arr.push_back(std::move(x));
+  }
+  template <class... Args> constexpr T &emplace_back(Args &&...args) {
+    if (!full())
+      return arr.emplace_back(std::forward<Args>(args)...);
+    grow([&] { arr.emplace_back(std::forward<Args>(args)...); },
+         room(args...));
+    return arr.back();
+  }
+
+  constexpr T &operator[](size_t i) { return arr[i]; }
+  constexpr const T &operator[](size_t i) const { return arr[i]; }
+  constexpr T *data() { return arr.data(); }
+  constexpr const T *data() const { return arr.data(); }
+  constexpr auto begin() { return arr.begin(); }
+  constexpr auto end() { return arr.end(); }
+  constexpr auto begin() const { return arr.begin(); }
+  constexpr auto end() const { return arr.end(); }
+
+private:
+  static constexpr bool kRelocates =
+      std::is_nothrow_constructible_v<T, Relocation, T &&>;
+
+  // The next push_back reallocates. The vector makes the same check right
+  // after, so the compiler folds the two into one branch.
+  constexpr bool full() const { return arr.size() == arr.capacity(); }
+
+  // The capacity for grow() to relocate to before inserting args: what the
+  // vector would grow to, or 0 to leave it to the vector when one of args is
+  // an element, which relocating first would move away from under it
+  template <class... Args> constexpr size_t room(const Args &...args) const {
+    if constexpr (!kRelocates)
+      return 0;
+    else {
+      auto isElement = [&]<class A>(const A &a) {
+        if constexpr (std::is_same_v<A, T>)
+          return std::is_constant_evaluated() ||
+                 (!std::less<const T *>()(std::addressof(a), arr.data()) &&
+                  std::less<const T *>()(std::addressof(a),
+                                         arr.data() + arr.size()));
+        else
+          return false;
+      };
+      if ((isElement(args) || ...))
+        return 0;
+      return arr.size() + std::max<size_t>(arr.size(), 1);
+    }
+  }
+
+  // Moves the elements into a buffer for n through T's Relocation
+  // constructor, where the vector would use its move constructor
+  constexpr void relocate(size_t n) {
+    std::vector<T, Alloc> next(arr.get_allocator());
+    next.reserve(n);
+    for (T &x : arr)
+      next.emplace_back(Relocation{}, std::move(x));
+    arr.swap(next);
+  }
+  constexpr size_t bytes() const { return arr.capacity() * sizeof(T); }
+
+  // The vector's copy, unless Alloc has a faster way to copy elements
+  static constexpr std::vector<T, Alloc> copyOf(const std::vector<T, Alloc> &v) {
+    if constexpr (requires {
+                    Alloc::bulkCopy(std::declval<T *>(), v.data(), v.size());
+                  }) {
+      if (!std::is_constant_evaluated()) {
+        std::vector<T, Alloc> copy(v.size(), v.get_allocator());
+        Alloc::bulkCopy(copy.data(), v.data(), v.size());
+        return copy;
+      }
+    }
+    return v;
+  }
+
+  constexpr void allocated() {
+    TRACE_PROBE(dynamicarray, alloc, this, arr.data(), bytes());
+    account(std::ptrdiff_t(bytes()));
+  }
+
+  constexpr void account([[maybe_unused]] std::ptrdiff_t delta) {
+    if constexpr (containerStats::kArrayStats)
+      if (!std::is_constant_evaluated() && delta)
+        typeStats<T>().liveArrayBytes.fetch_add(delta,
+                                                std::memory_order_relaxed);
+  }
+
+  // Runs op, which may reallocate, and reports it if it did. Kept out of
+  // line: it's the slow path of every insertion. Where T can be relocated,
+  // makes room for n elements first so that op doesn't reallocate itself.
+  template <class Op>
+  [[gnu::noinline]] constexpr void grow(Op op, [[maybe_unused]] size_t n = 0) {
+    [[maybe_unused]] const T *old = arr.data();
+    size_t oldBytes = bytes();
+    if constexpr (kRelocates)
+      if (n > arr.capacity())
+        relocate(n);
+    op();
+    if (arr.data() != old) {
+      TRACE_PROBE(dynamicarray, grow, this, old, arr.data(), bytes());
+      account(std::ptrdiff_t(bytes()) - std::ptrdiff_t(oldBytes));
+    }
+  }
+};
+
+// Deduction guide:
+// If DynamicArray(size_t, T) is called,
+// deduce DynamicArray<TypedClass<T>>.
+//
+// Example: DynamicArray(5, 1.3)
+//   -> becomes DynamicArray<TypedClass<double>>.
+template <typename T> DynamicArray(size_t, T) -> DynamicArray<TypedClass<T>>;
@@ -0,0 +1,210 @@
+#pragma once
+
+// Read-only view of an ELF file's symbol tables.
+//
+// The file is mapped, not read, and every name handed out is a string_view
+// into the mapping, so walking the tens of thousands of symbols in a large
+// binary copies nothing:
+//
+//   ElfFile elf("main");
+//   if (!elf.ok()) { std::cerr << elf.error() << '\n'; return 1; }
+//   elf.forEachSymbol([](std::string_view name) { ... });
+//
+// Both .symtab and .dynsym are walked, in that order; names present in both
+// come up twice. 32- and 64-bit files of either byte order are understood.
+// A malformed file is reported through error() rather than crashing: every
+// offset is checked against the size of the mapping before it is followed.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cerrno>
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class ElfFile {
+  const unsigned char *base = nullptr;
+  size_t size = 0;
+  bool is64 = false;
+  bool swap = false; // file byte order differs from ours
+  std::string why;
+
+  // Section header fields, independent of the ELF class
+  struct Section {
+    uint32_t type;
+    uint32_t link;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t entsize;
+  };
+  std::vector<Section> sections;
+
+  bool fail(std::string message) {
+    why = std::move(message);
+    return false;
+  }
+
+  template <class U> U get(size_t off) const {
+    U v;
+    std::memcpy(&v, base + off, sizeof v);
+    if (swap) {
+      if constexpr (sizeof(U) == 2)
+        v = __builtin_bswap16(v);
+      else if constexpr (sizeof(U) == 4)
+        v = __builtin_bswap32(v);
+      else if constexpr (sizeof(U) == 8)
+        v = __builtin_bswap64(v);
+    }
+    return v;
+  }
+
+  bool inFile(uint64_t off, uint64_t len) const {
+    return off <= size && len <= size - off;
+  }
+
+  Section section(size_t off) const {
+    if (is64)
+      return {get<uint32_t>(off + offsetof(Elf64_Shdr, sh_type)),
+              get<uint32_t>(off + offsetof(Elf64_Shdr, sh_link)),
+              get<uint64_t>(off + offsetof(Elf64_Shdr, sh_offset)),
+              get<uint64_t>(off + offsetof(Elf64_Shdr, sh_size)),
+              get<uint64_t>(off + offsetof(Elf64_Shdr, sh_entsize))};
+    return {get<uint32_t>(off + offsetof(Elf32_Shdr, sh_type)),
+            get<uint32_t>(off + offsetof(Elf32_Shdr, sh_link)),
+            get<uint32_t>(off + offsetof(Elf32_Shdr, sh_offset)),
+            get<uint32_t>(off + offsetof(Elf32_Shdr, sh_size)),
+            get<uint32_t>(off + offsetof(Elf32_Shdr, sh_entsize))};
+  }
+
+  bool parse() {
+    if (size < EI_NIDENT || std::memcmp(base, ELFMAG, SELFMAG) != 0)
+      return fail("not an ELF file");
+    if (base[EI_CLASS] != ELFCLASS32 && base[EI_CLASS] != ELFCLASS64)
+      return fail("unknown ELF class");
+    if (base[EI_DATA] != ELFDATA2LSB && base[EI_DATA] != ELFDATA2MSB)
+      return fail("unknown ELF byte order");
+    is64 = base[EI_CLASS] == ELFCLASS64;
+    swap = (base[EI_DATA] == ELFDATA2LSB) !=
+           (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__);
+    if (!inFile(0, is64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr)))
+      return fail("truncated ELF header");
+
+    uint64_t shoff = is64 ? get<uint64_t>(offsetof(Elf64_Ehdr, e_shoff))
+                          : get<uint32_t>(offsetof(Elf32_Ehdr, e_shoff));
+    uint16_t shentsize = get<uint16_t>(is64 ? offsetof(Elf64_Ehdr, e_shentsize)
+                                            : offsetof(Elf32_Ehdr, e_shentsize));
+    uint64_t shnum = get<uint16_t>(is64 ? offsetof(Elf64_Ehdr, e_shnum)
+                                        : offsetof(Elf32_Ehdr, e_shnum));
+    if (shoff == 0)
+      return true; // no section headers, so no symbols
+    size_t minEntsize = is64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr);
+    if (shentsize < minEntsize || !inFile(shoff, shentsize))
+      return fail("bad section header table");
+    if (shnum == 0) // more than 0xff00 sections: the count is in section 0
+      shnum = section(shoff).size;
+    if (shnum > size / shentsize || !inFile(shoff, shnum * shentsize))
+      return fail("section header table runs past the end of the file");
+
+    sections.reserve(shnum);
+    for (uint64_t i = 0; i < shnum; ++i)
+      sections.push_back(section(shoff + i * shentsize));
+    return true;
+  }
+
+public:
+  explicit ElfFile(const char *path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      why = std::string(path) + ": " + std::strerror(errno);
+      return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      why = std::string(path) + ": " + std::strerror(errno);
+      ::close(fd);
+      return;
+    }
+    if (st.st_size == 0) {
+      why = std::string(path) + ": empty file";
+      ::close(fd);
+      return;
+    }
+    void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      why = std::string(path) + ": mmap: " + std::strerror(errno);
+      return;
+    }
+    base = static_cast<const unsigned char *>(p);
+    size = st.st_size;
+    if (!parse())
+      why = std::string(path) + ": " + why;
+  }
+  ~ElfFile() {
+    if (base)
+      munmap(const_cast<unsigned char *>(base), size);
+  }
+  ElfFile(const ElfFile &) = delete;
+  ElfFile &operator=(const ElfFile &) = delete;
+
+  bool ok() const { return base && why.empty(); }
+  const std::string &error() const { return why; }
+
+  // Calls f(name) for every named symbol in .symtab, then in .dynsym.
+  // Returns false (and sets error()) if a symbol table was malformed; the
+  // symbols before the bad one have been visited by then.
+  template <class F> bool forEachSymbol(F &&f) {
+    if (!ok())
+      return false;
+    for (uint32_t type : {uint32_t(SHT_SYMTAB), uint32_t(SHT_DYNSYM)})
+      for (const Section &s : sections)
+        if (s.type == type && !walk(s, f))
+          return false;
+    return true;
+  }
+
+  // All named symbols, as views into the mapping
+  std::vector<std::string_view> symbols() {
+    std::vector<std::string_view> names;
+    forEachSymbol([&](std::string_view name) { names.push_back(name); });
+    return names;
+  }
+
+private:
+  template <class F> bool walk(const Section &symtab, F &f) {
+    size_t symSize = is64 ? sizeof(Elf64_Sym) : sizeof(Elf32_Sym);
+    if (symtab.entsize < symSize || !inFile(symtab.offset, symtab.size))
+      return fail("bad symbol table");
+    if (symtab.link >= sections.size())
+      return fail("symbol table has no string table");
+    const Section &strtab = sections[symtab.link];
+    if (!inFile(strtab.offset, strtab.size))
+      return fail("bad string table");
+    const char *strings = reinterpret_cast<const char *>(base + strtab.offset);
+
+    size_t nameField = is64 ? offsetof(Elf64_Sym, st_name)
+                            : offsetof(Elf32_Sym, st_name);
+    uint64_t count = symtab.size / symtab.entsize;
+    for (uint64_t i = 1; i < count; ++i) { // entry 0 is always null
+      uint32_t name = get<uint32_t>(symtab.offset + i * symtab.entsize + nameField);
+      if (name == 0)
+        continue;
+      if (name >= strtab.size)
+        return fail("symbol name outside its string table");
+      const void *end = std::memchr(strings + name, '\0', strtab.size - name);
+      if (!end)
+        return fail("unterminated symbol name");
+      f(std::string_view(strings + name,
+                         static_cast<const char *>(end) - (strings + name)));
+    }
+    return true;
+  }
+};
@@ -0,0 +1,295 @@
+#pragma once
+
+// Compile-time field enumeration for aggregates, and the generic binary
+// serialization, hashing and structure-of-arrays conversion built on it.
+//
+// There is no reflection in C++20, but for an aggregate such as
+//   struct Tick { int64_t ts; double price; int32_t qty; };
+// two tricks get surprisingly far:
+//  - Arity: Tick{a, b, c} compiles for up to three initializers of a type
+//    that converts to anything, and fails for four. So the number of fields
+//    is the largest N for which T{AnyField x N} is well-formed.
+//  - Access: once N is known, `auto &[a, b, c] = obj;` names every field.
+// Both are resolved entirely at compile time; nothing here inspects types at
+// run time.
+//
+// Limitations: members that are C arrays (brace elision makes them count as
+// several fields), aggregates with base classes, and more than kMaxFields
+// fields are not supported.
+
+#include "dynamicArray.hpp"
+#include "typedClass.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+inline constexpr std::size_t kMaxFields = 16;
+
+namespace detail {
+// Converts to any type, so it can stand in for any field's initializer
+struct AnyField {
+  template <class U> operator U() const;
+};
+
+template <class T, std::size_t... I>
+constexpr bool bracesInitWith(std::index_sequence<I...>) {
+  return requires { T{((void)I, AnyField{})...}; };
+}
+
+template <class T, std::size_t N = 0> constexpr std::size_t countFields() {
+  if constexpr (N < kMaxFields + 1 &&
+                bracesInitWith<T>(std::make_index_sequence<N + 1>{}))
+    return countFields<T, N + 1>();
+  else
+    return N;
+}
+} // namespace detail
+
+// Number of fields of the aggregate T
+template <class T>
+inline constexpr std::size_t field_count_v = detail::countFields<T>();
+
+// Aggregates whose fields can be enumerated: everything else (scalars,
+// strings, containers, ...) is handled as a single value.
+template <class T>
+concept Reflectable =
+    std::is_aggregate_v<T> && !std::is_array_v<T> &&
+    field_count_v<std::remove_cv_t<T>> > 0 &&
+    field_count_v<std::remove_cv_t<T>> <= kMaxFields;
+
+// Returns a tuple of references to every field of obj, in declaration order
+template <Reflectable T> constexpr auto tieFields(T &obj) {
+  constexpr std::size_t n = field_count_v<std::remove_cv_t<T>>;
+  // clang-format off
+  if constexpr (n == 1) { auto &[a] = obj; return std::tie(a); }
+  else if constexpr (n == 2) { auto &[a, b] = obj; return std::tie(a, b); }
+  else if constexpr (n == 3) { auto &[a, b, c] = obj; return std::tie(a, b, c); }
+  else if constexpr (n == 4) { auto &[a, b, c, d] = obj; return std::tie(a, b, c, d); }
+  else if constexpr (n == 5) { auto &[a, b, c, d, e] = obj; return std::tie(a, b, c, d, e); }
+  else if constexpr (n == 6) { auto &[a, b, c, d, e, f] = obj; return std::tie(a, b, c, d, e, f); }
+  else if constexpr (n == 7) { auto &[a, b, c, d, e, f, g] = obj; return std::tie(a, b, c, d, e, f, g); }
+  else if constexpr (n == 8) { auto &[a, b, c, d, e, f, g, h] = obj; return std::tie(a, b, c, d, e, f, g, h); }
+  else if constexpr (n == 9) { auto &[a, b, c, d, e, f, g, h, i] = obj; return std::tie(a, b, c, d, e, f, g, h, i); }
+  else if constexpr (n == 10) { auto &[a, b, c, d, e, f, g, h, i, j] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j); }
+  else if constexpr (n == 11) { auto &[a, b, c, d, e, f, g, h, i, j, k] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k); }
+  else if constexpr (n == 12) { auto &[a, b, c, d, e, f, g, h, i, j, k, l] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l); }
+  else if constexpr (n == 13) { auto &[a, b, c, d, e, f, g, h, i, j, k, l, m] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m); }
+  else if constexpr (n == 14) { auto &[a, b, c, d, e, f, g, h, i, j, k, l, m, o] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o); }
+  else if constexpr (n == 15) { auto &[a, b, c, d, e, f, g, h, i, j, k, l, m, o, p] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p); }
+  else { auto &[a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q] = obj; return std::tie(a, b, c, d, e, f, g, h, i, j, k, l, m, o, p, q); }
+  // clang-format on
+}
+
+// Calls f(field) for every field of obj, in declaration order
+template <Reflectable T, class F> constexpr void forEachField(T &obj, F &&f) {
+  std::apply([&](auto &...fields) { (f(fields), ...); }, tieFields(obj));
+}
+
+// std::tuple<F0, F1, ...> of the (unqualified) field types of T
+template <Reflectable T>
+using FieldTypes = decltype(std::apply(
+    [](auto &...fields) {
+      return std::tuple<std::remove_cvref_t<decltype(fields)>...>{};
+    },
+    tieFields(std::declval<T &>())));
+
+template <class T> struct IsTypedClass : std::false_type {};
+template <class T, class P>
+struct IsTypedClass<TypedClass<T, P>> : std::true_type {};
+
+template <class T> struct IsDynamicArray : std::false_type {};
+template <class T, class A>
+struct IsDynamicArray<DynamicArray<T, A>> : std::true_type {};
+
+// ---------------------------------------------------------------------------
+// Encoding
+//
+// encode() walks a value and hands its bytes to a Sink, i.e. anything with
+// write(const void *, size_t). Scalars are written in host byte order;
+// strings and DynamicArrays are prefixed with a uint64_t length; TypedClass
+// writes its payload; aggregates write their fields one after the other, so
+// padding never ends up in the output.
+// ---------------------------------------------------------------------------
+
+template <class Sink, class T> void encode(Sink &out, const T &x) {
+  if constexpr (std::is_arithmetic_v<T> || std::is_enum_v<T>) {
+    out.write(&x, sizeof x);
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    uint64_t n = x.size();
+    out.write(&n, sizeof n);
+    out.write(x.data(), x.size());
+  } else if constexpr (IsTypedClass<T>::value) {
+    encode(out, x.getData());
+  } else if constexpr (IsDynamicArray<T>::value) {
+    uint64_t n = x.size();
+    out.write(&n, sizeof n);
+    for (const auto &e : x)
+      encode(out, e);
+  } else if constexpr (Reflectable<T>) {
+    forEachField(x, [&](const auto &field) { encode(out, field); });
+  } else {
+    static_assert(sizeof(T) == 0, "encode: unsupported type");
+  }
+}
+
+// Sink that appends to a byte buffer
+struct ByteWriter {
+  std::vector<unsigned char> bytes;
+
+  void write(const void *p, std::size_t n) {
+    std::size_t at = bytes.size();
+    bytes.resize(at + n);
+    std::memcpy(bytes.data() + at, p, n);
+  }
+};
+
+// Sink that computes a 64-bit FNV-1a hash of everything written to it
+struct Fnv1aHasher {
+  uint64_t h = 14695981039346656037ull;
+
+  void write(const void *p, std::size_t n) {
+    auto *b = static_cast<const unsigned char *>(p);
+    for (std::size_t i = 0; i < n; ++i)
+      h = (h ^ b[i]) * 1099511628211ull;
+  }
+};
+
+// Binary serialization of any encodable value
+template <class T> std::vector<unsigned char> serialize(const T &x) {
+  ByteWriter w;
+  encode(w, x);
+  return std::move(w.bytes);
+}
+
+// Field-wise hash; equal values hash equally regardless of padding
+template <class T> uint64_t hashValue(const T &x) {
+  Fnv1aHasher h;
+  encode(h, x);
+  return h.h;
+}
+
+// ---------------------------------------------------------------------------
+// Decoding: the exact inverse of encode()
+// ---------------------------------------------------------------------------
+
+class ByteReader {
+  const unsigned char *p;
+  const unsigned char *end;
+
+public:
+  ByteReader(const std::vector<unsigned char> &bytes)
+      : p(bytes.data()), end(bytes.data() + bytes.size()) {}
+
+  void read(void *dst, std::size_t n) {
+    if (remaining() < n)
+      throw std::runtime_error("decode: truncated input");
+    std::memcpy(dst, p, n);
+    p += n;
+  }
+  std::size_t remaining() const { return static_cast<std::size_t>(end - p); }
+  bool atEnd() const { return p == end; }
+};
+
+template <class T> T decode(ByteReader &in) {
+  if constexpr (std::is_same_v<T, bool>) {
+    // Any byte but 0 or 1 in a bool is undefined behavior, not just wrong
+    unsigned char b = decode<unsigned char>(in);
+    if (b > 1)
+      throw std::runtime_error("decode: bool that is neither 0 nor 1");
+    return b == 1;
+  } else if constexpr (std::is_enum_v<T>) {
+    // Only an enum with a fixed underlying type holds every value of it;
+    // the range of one without is its enumerators' bits, unknown here
+    using U = std::underlying_type_t<T>;
+    static_assert(requires { T{U{}}; },
+                  "decode: enums need a fixed underlying type");
+    return T{decode<U>(in)};
+  } else if constexpr (std::is_arithmetic_v<T>) {
+    T x;
+    in.read(&x, sizeof x);
+    return x;
+  } else if constexpr (std::is_same_v<T, std::string>) {
+    // Checked before sizing the string: n comes from the input
+    uint64_t n = decode<uint64_t>(in);
+    if (n > in.remaining())
+      throw std::runtime_error("decode: truncated input");
+    std::string s(n, '\0');
+    in.read(s.data(), n);
+    return s;
+  } else if constexpr (IsTypedClass<T>::value) {
+    return T(decode<std::remove_cvref_t<decltype(std::declval<T>().getData())>>(in));
+  } else if constexpr (IsDynamicArray<T>::value) {
+    using E = std::remove_cvref_t<decltype(std::declval<T &>()[0])>;
+    T arr;
+    uint64_t n = decode<uint64_t>(in);
+    for (uint64_t i = 0; i < n; ++i)
+      arr.push_back(decode<E>(in));
+    return arr;
+  } else if constexpr (Reflectable<T>) {
+    T x{};
+    forEachField(x, [&](auto &field) {
+      field = decode<std::remove_cvref_t<decltype(field)>>(in);
+    });
+    return x;
+  } else {
+    static_assert(sizeof(T) == 0, "decode: unsupported type");
+  }
+}
+
+// The inverse of serialize(); throws unless bytes hold exactly one T
+template <class T> T deserialize(const std::vector<unsigned char> &bytes) {
+  ByteReader in(bytes);
+  T x = decode<T>(in);
+  if (!in.atEnd())
+    throw std::runtime_error("deserialize: trailing bytes");
+  return x;
+}
+
+// ---------------------------------------------------------------------------
+// Structure-of-arrays conversion
+//
+// toSoA() turns a DynamicArray of aggregates (or of TypedClass wrapping
+// one) into a tuple holding one DynamicArray per field:
+//   DynamicArray<TypedClass<Tick>> -> std::tuple<DynamicArray<int64_t>,
+//                                                DynamicArray<double>,
+//                                                DynamicArray<int32_t>>
+// ---------------------------------------------------------------------------
+
+template <class T> struct Payload {
+  using type = T;
+};
+template <class T, class P> struct Payload<TypedClass<T, P>> {
+  using type = T;
+};
+
+template <class Tuple> struct ColumnsOf;
+template <class... Fs> struct ColumnsOf<std::tuple<Fs...>> {
+  using type = std::tuple<DynamicArray<Fs>...>;
+};
+
+template <Reflectable T>
+using SoA = typename ColumnsOf<FieldTypes<T>>::type;
+
+template <class E> auto toSoA(const DynamicArray<E> &rows) {
+  using T = typename Payload<E>::type;
+  SoA<T> cols;
+  std::apply([&](auto &...c) { (c.reserve(rows.size()), ...); }, cols);
+  auto append = [&]<std::size_t... I>(const T &x, std::index_sequence<I...>) {
+    auto fields = tieFields(x);
+    (std::get<I>(cols).push_back(std::get<I>(fields)), ...);
+  };
+  for (const auto &row : rows) {
+    if constexpr (IsTypedClass<E>::value)
+      append(row.getData(), std::make_index_sequence<field_count_v<T>>{});
+    else
+      append(row, std::make_index_sequence<field_count_v<T>>{});
+  }
+  return cols;
+}
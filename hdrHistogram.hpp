@@ -0,0 +1,262 @@
+#pragma once
+
+// Latency histograms with bounded relative error, after HdrHistogram.
+//
+// Values (nanoseconds, usually) are counted in buckets that double in width
+// every 64 buckets, so any recorded value is reported within 1/64 (~1.6%)
+// of itself, from 1ns up to about 18 minutes, in 18KB:
+//
+//   HdrHistogram h;
+//   h.record(elapsedNs);
+//   h.percentile(99.9);    // an upper bound on the 99.9th percentile
+//
+// LatencyMetrics builds per-thread recording on top: each thread records
+// into histograms of its own, without locks or atomic read-modify-writes,
+// and readers merge every thread's histograms when they ask:
+//
+//   LatencyMetrics metrics({"parse", "execute"});
+//   metrics.record(0, ns);             // on any thread
+//   metrics.snapshot(0).percentile(50);
+//   metrics.dump(std::cout);           // percentiles of every metric
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+class HdrHistogram {
+public:
+  static constexpr unsigned kSubBits = 7;  // 128 sub-buckets: 1/64 error
+  static constexpr unsigned kMaxBits = 40; // values up to 2^40 - 1
+  static constexpr uint64_t kMaxValue = (uint64_t(1) << kMaxBits) - 1;
+  static constexpr size_t kHalf = size_t(1) << (kSubBits - 1);
+  static constexpr size_t kBuckets = (kMaxBits - kSubBits + 2) * kHalf;
+
+  HdrHistogram() : counts(kBuckets) {}
+
+  // Larger values are clamped to kMaxValue. Safe to call from one thread
+  // while others read: each field is written with a single relaxed store.
+  void record(uint64_t v) {
+    v = std::min(v, kMaxValue);
+    bump(counts[index(v)], 1);
+    bump(total, 1);
+    bump(sum, v);
+    if (v < load(lo))
+      store(lo, v);
+    if (v > load(hi))
+      store(hi, v);
+  }
+
+  uint64_t count() const { return load(total); }
+  uint64_t min() const { return count() ? load(lo) : 0; }
+  uint64_t max() const { return load(hi); }
+  double mean() const {
+    return count() ? double(load(sum)) / double(count()) : 0.0;
+  }
+
+  // The smallest bucket bound below which at least p percent of the values
+  // lie (never above max())
+  uint64_t percentile(double p) const {
+    uint64_t n = count();
+    if (n == 0)
+      return 0;
+    uint64_t rank =
+        std::max<uint64_t>(1, uint64_t(std::ceil(p / 100.0 * double(n))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += load(counts[i]);
+      if (seen >= rank)
+        return std::min(highestEquivalent(i), max());
+    }
+    return max();
+  }
+
+  // Adds other's values to this one. Not safe against a concurrent record()
+  // on *this; other may still be recorded into.
+  void merge(const HdrHistogram &other) {
+    for (size_t i = 0; i < kBuckets; ++i)
+      counts[i] += load(other.counts[i]);
+    if (other.count()) {
+      lo = std::min(lo, load(other.lo));
+      hi = std::max(hi, load(other.hi));
+    }
+    total += other.count();
+    sum += load(other.sum);
+  }
+
+  // Bucket index and the range of values it stands for
+  static size_t index(uint64_t v) {
+    unsigned shift = std::max(0, int(std::bit_width(v)) - int(kSubBits));
+    return (shift + 1) * kHalf + (v >> shift) - kHalf;
+  }
+  static uint64_t lowestEquivalent(size_t i) {
+    if (i < 2 * kHalf)
+      return i;
+    unsigned shift = unsigned(i / kHalf) - 1;
+    return uint64_t(i - shift * kHalf) << shift;
+  }
+  static uint64_t highestEquivalent(size_t i) {
+    return i + 1 < kBuckets ? lowestEquivalent(i + 1) - 1 : kMaxValue;
+  }
+
+private:
+  std::vector<uint64_t> counts;
+  uint64_t total = 0;
+  uint64_t sum = 0;
+  uint64_t lo = UINT64_MAX;
+  uint64_t hi = 0;
+
+  // Single-writer updates: plain loads and stores, atomic only so that
+  // concurrent readers see whole values
+  static uint64_t load(const uint64_t &x) {
+    return std::atomic_ref<uint64_t>(const_cast<uint64_t &>(x))
+        .load(std::memory_order_relaxed);
+  }
+  static void store(uint64_t &x, uint64_t v) {
+    std::atomic_ref<uint64_t>(x).store(v, std::memory_order_relaxed);
+  }
+  static void bump(uint64_t &x, uint64_t by) { store(x, load(x) + by); }
+};
+
+// Prints count, mean, min, p50, p90, p99, p99.9, p99.99 and max on one line
+inline void printSummary(std::ostream &os, const std::string &name,
+                         const HdrHistogram &h) {
+  char line[256];
+  std::snprintf(line, sizeof line,
+                "%-12s %10llu  mean %9.1f  min %8llu  p50 %8llu  p90 %8llu  "
+                "p99 %8llu  p99.9 %8llu  p99.99 %8llu  max %8llu",
+                name.c_str(), (unsigned long long)h.count(), h.mean(),
+                (unsigned long long)h.min(),
+                (unsigned long long)h.percentile(50),
+                (unsigned long long)h.percentile(90),
+                (unsigned long long)h.percentile(99),
+                (unsigned long long)h.percentile(99.9),
+                (unsigned long long)h.percentile(99.99),
+                (unsigned long long)h.max());
+  os << line << '\n';
+}
+
+// A fixed set of named histograms, recorded per thread and merged on read
+class LatencyMetrics {
+  using Histograms = std::vector<HdrHistogram>;
+
+  // Outlives the LatencyMetrics for as long as a thread that recorded into
+  // it is still exiting
+  struct Shared {
+    std::mutex lock;
+    std::vector<std::unique_ptr<Histograms>> live; // one per thread
+    Histograms retired; // folded in from threads that exited
+
+    void retire(const Histograms *h) {
+      std::lock_guard<std::mutex> guard(lock);
+      auto it = std::find_if(live.begin(), live.end(),
+                             [&](const auto &p) { return p.get() == h; });
+      for (size_t m = 0; m < h->size(); ++m)
+        retired[m].merge((*h)[m]);
+      live.erase(it);
+    }
+  };
+
+  // Ids index each thread's slots, and are reused once their LatencyMetrics
+  // is gone, so the slots grow to the most that ever lived at once rather
+  // than to how many were ever created. Generations are never reused: a
+  // slot left behind by an earlier user of the id doesn't match.
+  struct Ids {
+    std::mutex lock;
+    std::vector<size_t> free;
+    size_t next = 0;
+    uint64_t generations = 0;
+  };
+  static Ids &ids() {
+    static Ids i;
+    return i;
+  }
+
+  std::vector<std::string> metricNames;
+  size_t id;
+  uint64_t generation;
+  std::shared_ptr<Shared> shared;
+
+  // This thread's histograms, indexed by id, handed back to their owners
+  // (if those still exist) when the thread exits
+  struct Slot {
+    uint64_t generation = 0;
+    std::weak_ptr<Shared> owner;
+    Histograms *histograms = nullptr;
+  };
+  struct ThreadSlots {
+    std::vector<Slot> byId;
+    ~ThreadSlots() {
+      for (Slot &s : byId)
+        if (auto owner = s.owner.lock())
+          owner->retire(s.histograms);
+    }
+  };
+  static std::vector<Slot> &thisThread() {
+    static thread_local ThreadSlots t;
+    return t.byId;
+  }
+
+  Histograms &local() {
+    auto &byId = thisThread();
+    if (id < byId.size() && byId[id].generation == generation) [[likely]]
+      return *byId[id].histograms;
+    if (byId.size() <= id)
+      byId.resize(id + 1);
+    auto h = std::make_unique<Histograms>(metricNames.size());
+    byId[id] = {generation, shared, h.get()};
+    std::lock_guard<std::mutex> guard(shared->lock);
+    shared->live.push_back(std::move(h));
+    return *byId[id].histograms;
+  }
+
+public:
+  explicit LatencyMetrics(std::vector<std::string> names)
+      : metricNames(std::move(names)), shared(std::make_shared<Shared>()) {
+    shared->retired.resize(metricNames.size());
+    Ids &all = ids();
+    std::lock_guard<std::mutex> guard(all.lock);
+    if (all.free.empty()) {
+      id = all.next++;
+    } else {
+      id = all.free.back();
+      all.free.pop_back();
+    }
+    generation = ++all.generations;
+  }
+  ~LatencyMetrics() {
+    Ids &all = ids();
+    std::lock_guard<std::mutex> guard(all.lock);
+    all.free.push_back(id);
+  }
+  LatencyMetrics(const LatencyMetrics &) = delete;
+  LatencyMetrics &operator=(const LatencyMetrics &) = delete;
+
+  const std::vector<std::string> &names() const { return metricNames; }
+
+  // Lock-free once this thread has recorded into *this before
+  void record(size_t metric, uint64_t ns) { local()[metric].record(ns); }
+
+  // Every thread's values for one metric, merged
+  HdrHistogram snapshot(size_t metric) const {
+    std::lock_guard<std::mutex> guard(shared->lock);
+    HdrHistogram h = shared->retired[metric];
+    for (const auto &t : shared->live)
+      h.merge((*t)[metric]);
+    return h;
+  }
+
+  void dump(std::ostream &os) const {
+    for (size_t m = 0; m < metricNames.size(); ++m)
+      printSummary(os, metricNames[m], snapshot(m));
+  }
+};
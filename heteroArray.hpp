@@ -0,0 +1,93 @@
+#pragma once
+
+#include "dynamicArray.hpp"
+#include "typeList.hpp"
+
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// A heterogeneous container that keeps one DynamicArray bucket per type.
+//
+// DynamicArray<std::variant<int, double>> pays for the largest alternative
+// plus a tag in every slot, and has to branch on the tag for every element it
+// visits. HeteroArray<int, double> instead stores all ints contiguously in a
+// DynamicArray<int> and all doubles in a DynamicArray<double>, so visiting is
+// a plain loop over each bucket in turn that the compiler can vectorize.
+//
+// The price is that insertion order is only kept within a type: visitation
+// sees every int first, then every double, and so on in TypeList order.
+template <class... Ts> class HeteroArray {
+  static_assert(sizeof...(Ts) > 0, "HeteroArray needs at least one type");
+
+public:
+  using Types = TypeList<Ts...>;
+
+private:
+  std::tuple<DynamicArray<Ts>...> buckets;
+
+  template <class T> static constexpr void checkType() {
+    static_assert(contains_v<T, Types>,
+                  "type is not one of the HeteroArray's alternatives");
+  }
+
+public:
+  HeteroArray() = default;
+
+  // Appends x to the bucket of its own (decayed) type. No conversions are
+  // applied: push_back(1.0f) on a HeteroArray<int, double> is an error.
+  template <class U> void push_back(U &&x) {
+    using T = std::remove_cvref_t<U>;
+    checkType<T>();
+    std::get<DynamicArray<T>>(buckets).push_back(std::forward<U>(x));
+  }
+
+  template <class T, class... Args> T &emplace_back(Args &&...args) {
+    checkType<T>();
+    return std::get<DynamicArray<T>>(buckets).emplace_back(
+        std::forward<Args>(args)...);
+  }
+
+  // The contiguous bucket holding every T
+  template <class T> DynamicArray<T> &bucket() {
+    checkType<T>();
+    return std::get<DynamicArray<T>>(buckets);
+  }
+  template <class T> const DynamicArray<T> &bucket() const {
+    checkType<T>();
+    return std::get<DynamicArray<T>>(buckets);
+  }
+
+  // Number of elements of one type / of all types
+  template <class T> size_t count() const { return bucket<T>().size(); }
+  size_t size() const { return (std::get<DynamicArray<Ts>>(buckets).size() + ...); }
+  bool empty() const { return size() == 0; }
+
+  template <class T> void reserve(size_t n) { bucket<T>().reserve(n); }
+
+  // Calls f(bucket) once per type, in TypeList order. Use this when the
+  // work is naturally a whole-array operation (sum, sort, memcpy, ...).
+  template <class F> void visitBuckets(F &&f) {
+    (f(std::get<DynamicArray<Ts>>(buckets)), ...);
+  }
+  template <class F> void visitBuckets(F &&f) const {
+    (f(std::get<DynamicArray<Ts>>(buckets)), ...);
+  }
+
+  // Calls f(x) for every element: all elements of the first type, then all
+  // of the second, ... f is usually a generic lambda; each type gets its own
+  // instantiation and its own branch-free inner loop.
+  template <class F> void forEach(F &&f) {
+    visitBuckets([&](auto &b) {
+      for (auto &x : b)
+        f(x);
+    });
+  }
+  template <class F> void forEach(F &&f) const {
+    visitBuckets([&](const auto &b) {
+      for (const auto &x : b)
+        f(x);
+    });
+  }
+};
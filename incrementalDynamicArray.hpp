@@ -0,0 +1,222 @@
+#pragma once
+
+// A DynamicArray-like container that grows without a pause proportional to
+// its size.
+//
+// When a std::vector runs out of room, the push_back that noticed moves
+// every element to the new buffer before it returns. An
+// IncrementalDynamicArray<T> only allocates the new buffer then, and moves
+// kStep elements across on each of the following insertions, the way Redis
+// rehashes its dictionaries. Until they've all moved, the array spans two
+// buffers:
+//
+//   IncrementalDynamicArray<int> a;
+//   for (int i = 0; i < 100'000'000; ++i)
+//     a.push_back(i);      // no push_back moves more than kStep elements
+//   a[12345];              // indexing works across both buffers
+//   a.finishGrowth();      // moves what's left, e.g. while idle
+//
+// Doubling leaves as many free slots as there are elements to move, so the
+// move always ends before the new buffer fills up. The cost is a branch on
+// every access while it's under way, and no data(): the elements aren't
+// contiguous until finishGrowth() or the last step.
+//
+// The old buffer is freed by the step that empties it, which for a big
+// buffer means an munmap; pass it to arrayReclaimer() with
+// DeferredBuffers = true to take that off the inserting thread as well.
+
+#include "deferredDynamicArray.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct NoArrayReclaimer {};
+
+template <class T, bool DeferredBuffers = false>
+class IncrementalDynamicArray
+    : private std::conditional_t<DeferredBuffers, UsesArrayReclaimer,
+                                 NoArrayReclaimer> {
+public:
+  static constexpr size_t kStep = 4; // elements moved per insertion
+
+  IncrementalDynamicArray() = default;
+  IncrementalDynamicArray(size_t sz) : IncrementalDynamicArray(sz, T{}) {}
+  IncrementalDynamicArray(size_t sz, const T &val) {
+    reserve(sz);
+    for (size_t i = 0; i < sz; ++i)
+      emplace_back(val);
+  }
+  IncrementalDynamicArray(std::initializer_list<T> init) {
+    reserve(init.size());
+    for (const T &x : init)
+      emplace_back(x);
+  }
+
+  IncrementalDynamicArray(const IncrementalDynamicArray &o) {
+    reserve(o.size());
+    for (size_t i = 0; i < o.size(); ++i)
+      emplace_back(o[i]);
+  }
+  IncrementalDynamicArray(IncrementalDynamicArray &&o) noexcept { swap(o); }
+  IncrementalDynamicArray &operator=(IncrementalDynamicArray o) noexcept {
+    swap(o);
+    return *this;
+  }
+  ~IncrementalDynamicArray() {
+    for (size_t i = 0; i < count; ++i)
+      std::destroy_at(&(*this)[i]);
+    release(old, oldCap);
+    release(cur, curCap);
+  }
+
+  void swap(IncrementalDynamicArray &o) noexcept {
+    std::swap(cur, o.cur);
+    std::swap(curCap, o.curCap);
+    std::swap(old, o.old);
+    std::swap(oldCap, o.oldCap);
+    std::swap(count, o.count);
+    std::swap(oldCount, o.oldCount);
+    std::swap(migrated, o.migrated);
+  }
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  size_t capacity() const { return curCap; }
+  bool growing() const { return old != nullptr; }
+
+  // Elements [migrated, oldCount) are still in the old buffer
+  T &operator[](size_t i) {
+    return i - migrated < oldCount - migrated ? old[i] : cur[i];
+  }
+  const T &operator[](size_t i) const {
+    return i - migrated < oldCount - migrated ? old[i] : cur[i];
+  }
+  T &back() { return (*this)[count - 1]; }
+  const T &back() const { return (*this)[count - 1]; }
+
+  // Grows to at least n, incrementally like any other growth. A growth
+  // still under way is finished first.
+  void reserve(size_t n) {
+    if (n <= curCap)
+      return;
+    finishGrowth();
+    startGrowth(n);
+  }
+
+  void push_back(const T &x) { emplace_back(x); }
+  void push_back(T &&x) { emplace_back(std::move(x)); }
+  // args may refer to an element: nothing moves before they're used
+  template <class... Args> T &emplace_back(Args &&...args) {
+    if (count == curCap && growing()) {
+      // Only after a reserve() that left too little room: finishing the
+      // growth would move what args refer to, so build the element first
+      T x(std::forward<Args>(args)...);
+      finishGrowth();
+      startGrowth(std::max<size_t>(2 * curCap, 8));
+      return append(std::move(x));
+    }
+    if (count == curCap)
+      startGrowth(std::max<size_t>(2 * curCap, 8)); // leaves old elements put
+    return append(std::forward<Args>(args)...);
+  }
+
+  // Moves whatever the last growth left behind
+  void finishGrowth() {
+    if (growing())
+      migrate(oldCount - migrated);
+  }
+
+  template <class A> class Iterator {
+    A *a;
+    size_t i;
+
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = decltype(&(*a)[0]);
+    using reference = decltype((*a)[0]);
+
+    Iterator() = default;
+    Iterator(A *a, size_t i) : a(a), i(i) {}
+    reference operator*() const { return (*a)[i]; }
+    pointer operator->() const { return &(*a)[i]; }
+    Iterator &operator++() {
+      ++i;
+      return *this;
+    }
+    Iterator operator++(int) { return {a, i++}; }
+    bool operator==(const Iterator &o) const { return i == o.i; }
+  };
+  auto begin() { return Iterator<IncrementalDynamicArray>(this, 0); }
+  auto end() { return Iterator<IncrementalDynamicArray>(this, count); }
+  auto begin() const {
+    return Iterator<const IncrementalDynamicArray>(this, 0);
+  }
+  auto end() const {
+    return Iterator<const IncrementalDynamicArray>(this, count);
+  }
+
+private:
+  T *cur = nullptr;
+  size_t curCap = 0;
+  T *old = nullptr; // non-null while growing
+  size_t oldCap = 0;
+  size_t count = 0;
+  size_t oldCount = 0; // elements the old buffer held when growth began
+  size_t migrated = 0; // of those, how many have moved
+
+  template <class... Args> T &append(Args &&...args) {
+    T *p = std::construct_at(cur + count, std::forward<Args>(args)...);
+    ++count;
+    if (growing())
+      migrate(kStep);
+    return *p;
+  }
+
+  void startGrowth(size_t n) {
+    T *fresh = std::allocator<T>().allocate(n);
+    old = cur;
+    oldCap = curCap;
+    oldCount = count;
+    migrated = 0;
+    cur = fresh;
+    curCap = n;
+    if (oldCount == 0)
+      finish();
+  }
+
+  // Moves up to n more elements. An element stays in the old buffer until
+  // its copy exists, so a throwing copy leaves everything in place.
+  void migrate(size_t n) {
+    size_t end = std::min(oldCount, migrated + n);
+    for (; migrated < end; ++migrated) {
+      std::construct_at(cur + migrated, std::move_if_noexcept(old[migrated]));
+      std::destroy_at(old + migrated);
+    }
+    if (migrated == oldCount)
+      finish();
+  }
+
+  void finish() {
+    release(old, oldCap);
+    old = nullptr;
+    oldCap = oldCount = migrated = 0;
+  }
+
+  static void release(T *p, size_t n) {
+    if (!p)
+      return;
+    if constexpr (DeferredBuffers) {
+      if (n * sizeof(T) >= arrayReclaimer().minBytes())
+        return arrayReclaimer().deferDeallocate(p, n);
+    }
+    std::allocator<T>().deallocate(p, n);
+  }
+};
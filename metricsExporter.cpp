@@ -0,0 +1,166 @@
+// Scrapes a MetricsExporter over localhost while worker threads construct
+// TypedClass objects and grow DynamicArrays, and checks what comes back:
+// every scrape parses, counters never go down, and the live bytes drop to
+// zero once the workers' arrays are gone. Then that clients sending too
+// much or too slowly are dropped. Exits non-zero on any failure.
+//
+// Built with INTERESTING_ARRAY_STATS, so DynamicArray keeps its byte count.
+
+#include "dynamicArray.hpp"
+#include "metricsExporter.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using Counted = TypedClass<double, CountingPolicy>;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  std::printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+  failures += !ok;
+}
+
+// A blocking HTTP/1.1 GET, returning the whole response
+static std::string get(uint16_t port, const char *path) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  std::string response;
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) == 0) {
+    std::string request = std::string("GET ") + path +
+                          " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) ==
+        ssize_t(request.size())) {
+      char buf[4096];
+      ssize_t r;
+      while ((r = ::read(fd, buf, sizeof buf)) > 0)
+        response.append(buf, size_t(r));
+    }
+  }
+  ::close(fd);
+  return response;
+}
+
+// Sends the start of a request and waits up to 2s for the server to hang
+// up; true if it did
+static bool dropped(uint16_t port, const std::string &partial) {
+  int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  timeval wait{2, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &wait, sizeof wait);
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  bool closed = false;
+  if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) == 0 &&
+      ::send(fd, partial.data(), partial.size(), MSG_NOSIGNAL) ==
+          ssize_t(partial.size())) {
+    char buf[256];
+    ssize_t r = ::read(fd, buf, sizeof buf);
+    closed = r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+  }
+  ::close(fd);
+  return closed;
+}
+
+// "name{labels} value" lines of a scrape, keyed by everything before the value
+static std::map<std::string, double> samples(const std::string &response) {
+  std::map<std::string, double> out;
+  size_t pos = response.find("\r\n\r\n");
+  if (pos == std::string::npos)
+    return out;
+  for (pos += 4; pos < response.size();) {
+    size_t end = response.find('\n', pos);
+    std::string line = response.substr(pos, end - pos);
+    pos = end == std::string::npos ? response.size() : end + 1;
+    if (line.empty() || line[0] == '#')
+      continue;
+    size_t space = line.rfind(' ');
+    out[line.substr(0, space)] = std::stod(line.substr(space + 1));
+  }
+  return out;
+}
+
+int main() {
+  MetricsExporter exporter;
+  if (!exporter.ok()) {
+    std::printf("exporter didn't start: %s\n", exporter.error().c_str());
+    return 1;
+  }
+  exporter.addCollector(renderContainerStats);
+  std::printf("serving on 127.0.0.1:%u\n", unsigned(exporter.port()));
+
+  {
+    DynamicArray<Counted> first{Counted(1.0)}; // so the first scrape has copies
+  }
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> workers;
+  for (int t = 0; t < 4; ++t)
+    workers.emplace_back([&stop] {
+      while (!stop.load(std::memory_order_relaxed)) {
+        DynamicArray<Counted> a;
+        for (int i = 0; i < 1000; ++i)
+          a.emplace_back(double(i));
+        DynamicArray<Counted> b = a;
+        DynamicArray<int> ints(256, 7);
+      }
+    });
+
+  const std::string copies =
+      "typedclass_constructions_total{type=\"double\",kind=\"copy\"}";
+  const std::string bytes = "dynamicarray_live_bytes{type=\"TypedClass<double, "
+                            "CountingPolicy>\"}";
+  double lastCopies = 0;
+  bool parsed = true, monotonic = true, sawBytes = false;
+  for (int i = 0; i < 50; ++i) {
+    std::string r = get(exporter.port(), "/metrics");
+    auto s = samples(r);
+    parsed &= r.starts_with("HTTP/1.1 200 OK\r\n") && s.count(copies);
+    monotonic &= s[copies] >= lastCopies;
+    lastCopies = s[copies];
+    sawBytes |= s[bytes] > 0;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  stop = true;
+  for (auto &t : workers)
+    t.join();
+
+  check(parsed, "every scrape is a 200 with the copy counter in it");
+  check(monotonic, "the copy counter never goes down between scrapes");
+  check(lastCopies > 0, "copies were counted while the workload ran");
+  check(sawBytes, "live DynamicArray bytes were reported while it ran");
+
+  auto after = samples(get(exporter.port(), "/metrics"));
+  check(!after.count(bytes), "no live bytes once the arrays are destroyed");
+  check(after[copies] >= lastCopies, "counters survive the workers");
+  check(get(exporter.port(), "/nope").starts_with("HTTP/1.1 404"),
+        "other paths are 404");
+  check(exporter.scrapeCount() == 51, "every /metrics request was counted");
+
+  MetricsExporter strict(0, std::chrono::milliseconds(100));
+  check(dropped(strict.port(), "GET /metrics HTTP/1.1\r\n"),
+        "a client that stops half-way through its headers is dropped");
+  check(dropped(strict.port(), "GET /metrics HTTP/1.1\r\nX: " +
+                                   std::string(9000, 'x')),
+        "a client sending more than 8KB of headers is dropped");
+  check(get(strict.port(), "/metrics").starts_with("HTTP/1.1 200"),
+        "complete requests are still answered");
+
+  std::printf("%d check(s) failed\n", failures);
+  return failures != 0;
+}
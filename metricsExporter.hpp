@@ -0,0 +1,312 @@
+#pragma once
+
+// A minimal Prometheus exporter: one background thread running an epoll
+// loop that answers GET /metrics on a local port.
+//
+//   MetricsExporter exporter(9464);       // 0 picks a free port
+//   exporter.addCollector(renderContainerStats);
+//   // curl http://127.0.0.1:9464/metrics
+//
+// Collectors append Prometheus text exposition format to a string. They run
+// on the exporter thread for every scrape, so they must only read state
+// that is safe to read concurrently; renderContainerStats reads relaxed
+// atomics and never blocks the threads updating them.
+//
+// The server binds to 127.0.0.1 only, serves one request per connection
+// and drops clients that send more than 8KB of headers, or that haven't
+// sent all of them within the header timeout (5s by default). If it can't
+// start, or its loop fails later on, ok() is false and error() says why.
+
+#include "containerStats.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Escapes a label value: backslash, double quote and newline
+inline void appendLabelValue(std::string &out, std::string_view v) {
+  for (char c : v) {
+    if (c == '\\' || c == '"')
+      out += '\\';
+    if (c == '\n') {
+      out += "\\n";
+      continue;
+    }
+    out += c;
+  }
+}
+
+// TypedClass constructions and live DynamicArray bytes, per type
+inline void renderContainerStats(std::string &out) {
+  static const char *kinds[] = {"default", "value", "copy", "move"};
+  out += "# HELP typedclass_constructions_total TypedClass<T, CountingPolicy> "
+         "constructions, by T and constructor.\n"
+         "# TYPE typedclass_constructions_total counter\n";
+  forEachTypeStats([&](const TypeStats &s) {
+    for (int k = 0; k < 4; ++k) {
+      uint64_t n = s.constructions[k].load(std::memory_order_relaxed);
+      if (n == 0)
+        continue;
+      out += "typedclass_constructions_total{type=\"";
+      appendLabelValue(out, s.name);
+      out += "\",kind=\"";
+      out += kinds[k];
+      out += "\"} ";
+      out += std::to_string(n);
+      out += '\n';
+    }
+  });
+  out += "# HELP dynamicarray_live_bytes Capacity of live DynamicArray<T> "
+         "buffers, by T.\n"
+         "# TYPE dynamicarray_live_bytes gauge\n";
+  forEachTypeStats([&](const TypeStats &s) {
+    int64_t bytes = s.liveArrayBytes.load(std::memory_order_relaxed);
+    if (bytes == 0)
+      return;
+    out += "dynamicarray_live_bytes{type=\"";
+    appendLabelValue(out, s.name);
+    out += "\"} ";
+    out += std::to_string(bytes);
+    out += '\n';
+  });
+}
+
+class MetricsExporter {
+  using Collector = std::function<void(std::string &)>;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kMaxHeaderBytes = 8192;
+
+  int listener = -1;
+  int epoll = -1;
+  int wakeup = -1; // eventfd that tells the loop to stop
+  uint16_t boundPort = 0;
+  Clock::duration headerTimeout;
+  std::string why;
+  std::mutex collectorsLock;
+  std::vector<Collector> collectors;
+  std::atomic<uint64_t> scrapes{0};
+  std::atomic<bool> failed{false}; // the loop gave up; set after why
+  std::thread loop;
+
+  struct Connection {
+    Clock::time_point deadline; // for the complete headers
+    std::string in;
+    std::string out;
+    size_t sent = 0;
+  };
+
+  bool fail(const char *what) {
+    why = std::string(what) + ": " + std::strerror(errno);
+    return false;
+  }
+
+  bool start(uint16_t port) {
+    listener = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener < 0)
+      return fail("socket");
+    int one = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(listener, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0)
+      return fail("bind");
+    if (::listen(listener, 64) != 0)
+      return fail("listen");
+    socklen_t len = sizeof addr;
+    getsockname(listener, reinterpret_cast<sockaddr *>(&addr), &len);
+    boundPort = ntohs(addr.sin_port);
+
+    epoll = epoll_create1(EPOLL_CLOEXEC);
+    wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll < 0 || wakeup < 0)
+      return fail("epoll");
+    watch(listener, EPOLLIN);
+    watch(wakeup, EPOLLIN);
+    return true;
+  }
+
+  void watch(int fd, uint32_t events) {
+    epoll_event ev{};
+    ev.events = events;
+    ev.data.fd = fd;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &ev);
+  }
+
+  void run() {
+    std::unordered_map<int, Connection> conns;
+    epoll_event events[64];
+    for (;;) {
+      int n = epoll_wait(epoll, events, 64, waitMs(conns));
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n < 0) { // any other error would come back on every retry
+        fail("epoll_wait");
+        failed.store(true, std::memory_order_release);
+        for (auto &[c, _] : conns)
+          ::close(c);
+        return;
+      }
+      for (int i = 0; i < n; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == wakeup) {
+          for (auto &[c, _] : conns)
+            ::close(c);
+          return;
+        }
+        if (fd == listener) {
+          int c;
+          while ((c = ::accept4(listener, nullptr, nullptr,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+            conns[c].deadline = Clock::now() + headerTimeout;
+            watch(c, EPOLLIN | EPOLLRDHUP);
+          }
+          continue;
+        }
+        auto it = conns.find(fd);
+        if (it == conns.end())
+          continue;
+        if (!service(fd, it->second)) {
+          ::close(fd); // also takes it out of the epoll set
+          conns.erase(it);
+        }
+      }
+      dropLate(conns);
+    }
+  }
+
+  // Until the earliest header deadline, or forever with none pending
+  int waitMs(const std::unordered_map<int, Connection> &conns) const {
+    auto first = Clock::time_point::max();
+    for (const auto &[_, c] : conns)
+      if (c.out.empty())
+        first = std::min(first, c.deadline);
+    if (first == Clock::time_point::max())
+      return -1;
+    auto left = first - Clock::now();
+    auto ms = std::chrono::ceil<std::chrono::milliseconds>(left).count();
+    return int(std::clamp<int64_t>(ms, 0, 60'000));
+  }
+
+  // Closes the connections still waiting for their headers past the deadline
+  void dropLate(std::unordered_map<int, Connection> &conns) {
+    auto now = Clock::now();
+    std::erase_if(conns, [&](const auto &entry) {
+      if (!entry.second.out.empty() || entry.second.deadline > now)
+        return false;
+      ::close(entry.first);
+      return true;
+    });
+  }
+
+  // Reads what's there, answers once the headers are complete, writes what
+  // fits. Returns false when the connection is done with.
+  bool service(int fd, Connection &c) {
+    if (c.out.empty()) {
+      char buf[4096];
+      ssize_t r;
+      while ((r = ::read(fd, buf, sizeof buf)) > 0) {
+        c.in.append(buf, size_t(r));
+        if (c.in.size() > kMaxHeaderBytes)
+          return false;
+      }
+      if (r < 0 && errno != EAGAIN)
+        return false;
+      if (c.in.find("\r\n\r\n") == std::string::npos)
+        return r != 0; // r == 0: closed half-way
+      c.out = respond(c.in);
+      epoll_event ev{};
+      ev.events = EPOLLOUT;
+      ev.data.fd = fd;
+      epoll_ctl(epoll, EPOLL_CTL_MOD, fd, &ev);
+    }
+    while (c.sent < c.out.size()) {
+      ssize_t w = ::send(fd, c.out.data() + c.sent, c.out.size() - c.sent,
+                         MSG_NOSIGNAL);
+      if (w < 0)
+        return errno == EAGAIN;
+      c.sent += size_t(w);
+    }
+    return false;
+  }
+
+  std::string respond(std::string_view request) {
+    std::string_view line = request.substr(0, request.find("\r\n"));
+    const char *status = "200 OK";
+    std::string body;
+    if (line.starts_with("GET /metrics ") || line.starts_with("GET /metrics?")) {
+      scrapes.fetch_add(1, std::memory_order_relaxed);
+      std::lock_guard<std::mutex> guard(collectorsLock);
+      for (const Collector &collect : collectors)
+        collect(body);
+    } else if (line.starts_with("GET ")) {
+      status = "404 Not Found";
+      body = "try /metrics\n";
+    } else {
+      status = "405 Method Not Allowed";
+    }
+    std::string out = "HTTP/1.1 ";
+    out += status;
+    out += "\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+           "Content-Length: ";
+    out += std::to_string(body.size());
+    out += "\r\nConnection: close\r\n\r\n";
+    out += body;
+    return out;
+  }
+
+public:
+  explicit MetricsExporter(
+      uint16_t port = 0,
+      std::chrono::milliseconds headerTimeout = std::chrono::seconds(5))
+      : headerTimeout(headerTimeout) {
+    if (start(port))
+      loop = std::thread([this] { run(); });
+  }
+  ~MetricsExporter() {
+    if (loop.joinable()) {
+      uint64_t one = 1;
+      [[maybe_unused]] ssize_t w = ::write(wakeup, &one, sizeof one);
+      loop.join();
+    }
+    for (int fd : {listener, epoll, wakeup})
+      if (fd >= 0)
+        ::close(fd);
+  }
+  MetricsExporter(const MetricsExporter &) = delete;
+  MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+  bool ok() const {
+    return loop.joinable() && !failed.load(std::memory_order_acquire);
+  }
+  const std::string &error() const { return why; }
+  uint16_t port() const { return boundPort; }
+  uint64_t scrapeCount() const {
+    return scrapes.load(std::memory_order_relaxed);
+  }
+
+  void addCollector(Collector c) {
+    std::lock_guard<std::mutex> guard(collectorsLock);
+    collectors.push_back(std::move(c));
+  }
+};
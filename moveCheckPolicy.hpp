@@ -0,0 +1,43 @@
+#pragma once
+
+// A TypedClass policy that catches uses of moved-from objects.
+//
+// After `b = std::move(a)`, `a` is in a valid but unspecified state: the
+// only sensible things to do with it are to assign it a new value or let it
+// be destroyed (see valueCategories.cpp). With
+//   TypedClass<std::string, MoveCheckPolicy>
+// any other use (getData(), copying it, moving from it again) prints what
+// happened and traps, in debug builds.
+//
+// With NDEBUG defined the policy is an empty class with no-op hooks, so it
+// adds neither space nor instructions: TypedClass<T, MoveCheckPolicy> is
+// then the same size and code as TypedClass<T, SilentPolicy>.
+
+#include "typedClass.hpp"
+
+#ifndef NDEBUG
+#include <cstdio>
+#endif
+
+#ifndef NDEBUG
+
+class MoveCheckPolicy : public SilentPolicy {
+  bool poisoned = false;
+
+public:
+  void accessed() const {
+    if (poisoned) [[unlikely]] {
+      std::fprintf(stderr, "MoveCheckPolicy: use of a moved-from TypedClass "
+                           "(only assignment and destruction are allowed)\n");
+      __builtin_trap();
+    }
+  }
+  void movedFrom() { poisoned = true; }
+  void assigned() { poisoned = false; }
+};
+
+#else
+
+struct MoveCheckPolicy : SilentPolicy {};
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * NOTE: Move-only types
+ * A deep copy of a large container is easy to write by accident: passing it
+ * by value, `auto x = y;`, capturing it in a lambda. When a type deletes its
+ * copy constructor every one of those becomes a compile error, and the copy
+ * has to be asked for explicitly with clone().
+ *
+ * The static_asserts below state that copies do not compile, so
+ * uncommenting any of the lines marked "error" in main() is a build
+ * failure; the moveOnlyCopy* tests (moveOnlyCopies.cpp) make sure of it.
+ */
+
+#include "moveOnly.hpp"
+
+#include <iostream>
+#include <type_traits>
+#include <utility>
+
+// Copying is rejected...
+static_assert(!std::is_copy_constructible_v<MoveOnlyDynamicArray<int>>);
+static_assert(!std::is_copy_assignable_v<MoveOnlyDynamicArray<int>>);
+static_assert(!std::is_copy_constructible_v<MoveOnlyTypedClass<double>>);
+static_assert(!std::is_copy_assignable_v<MoveOnlyTypedClass<double>>);
+// ...including by slicing to the copyable base or passing by value
+static_assert(!std::is_convertible_v<MoveOnlyDynamicArray<int> &,
+                                     const DynamicArray<int> &>);
+static_assert(!std::is_invocable_v<void (*)(MoveOnlyDynamicArray<int>),
+                                   MoveOnlyDynamicArray<int> &>);
+// ...while moving still works, and doesn't throw
+static_assert(std::is_nothrow_move_constructible_v<MoveOnlyDynamicArray<int>>);
+static_assert(std::is_nothrow_move_constructible_v<MoveOnlyTypedClass<double>>);
+// The ordinary flavors are unaffected
+static_assert(std::is_copy_constructible_v<DynamicArray<int>>);
+static_assert(std::is_copy_constructible_v<TypedClass<double>>);
+
+// CTAD works the same way as for DynamicArray and TypedClass
+static_assert(std::is_same_v<decltype(MoveOnlyDynamicArray{1, 2, 3}),
+                             MoveOnlyDynamicArray<int>>);
+static_assert(std::is_same_v<decltype(MoveOnlyDynamicArray(5, 1.3)),
+                             MoveOnlyDynamicArray<TypedClass<double>>>);
+static_assert(std::is_same_v<decltype(MoveOnlyTypedClass{1.5}),
+                             TypedClass<double, MoveOnlyPolicy>>);
+
+int main() {
+  // Case 1: Braced list → MoveOnlyDynamicArray<int>
+  MoveOnlyDynamicArray arr{1, 2, 3};
+  // MoveOnlyDynamicArray copy = arr;            // error: copy is deleted
+  MoveOnlyDynamicArray moved = std::move(arr);
+  MoveOnlyDynamicArray cloned = moved.clone();
+  std::cout << "moved: " << moved.size() << " elements, cloned: "
+            << cloned.size() << " elements" << std::endl;
+  std::cout << "--------------------------------------------------------------"
+            << std::endl;
+
+  // Case 2: Move-only elements in a move-only array; clone() clones each
+  MoveOnlyDynamicArray<MoveOnlyTypedClass<double>> typed;
+  typed.push_back(MoveOnlyTypedClass{10.34});
+  typed.push_back(MoveOnlyTypedClass{9.23});
+  // auto element = typed[0];                     // error: copy is deleted
+  auto typedClone = typed.clone();
+  for (int j = 0; const auto &i : typedClone) {
+    std::cout << j++ << ": " << i.getData() << std::endl;
+  }
+  std::cout << "--------------------------------------------------------------"
+            << std::endl;
+
+  // Case 3: Converting to and from an ordinary DynamicArray is explicit, and
+  // moves the buffer rather than copying it
+  DynamicArray<int> plain(4, 7);
+  const int *buffer = plain.data();
+  MoveOnlyDynamicArray<int> owned(std::move(plain));
+  DynamicArray<int> back = std::move(owned).release();
+  std::cout << "same buffer after the round trip: " << std::boolalpha
+            << (back.data() == buffer) << std::endl;
+  return 0;
+}
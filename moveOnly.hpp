@@ -0,0 +1,88 @@
+#pragma once
+
+// Move-only flavors of TypedClass and DynamicArray, for hot paths where an
+// accidental deep copy (of a multi-gigabyte array, say) must not compile.
+//
+//   MoveOnlyDynamicArray big(1'000'000'000, 0.0);
+//   auto other = big;              // error: copy constructor is deleted
+//   auto other = std::move(big);   // fine, steals the buffer
+//   auto other = big.clone();      // fine, the copy is spelled out
+//
+// Both deduce their template arguments the same way as the originals:
+//   MoveOnlyDynamicArray{1, 2, 3}  -> MoveOnlyDynamicArray<int>
+//   MoveOnlyDynamicArray(5, 1.3)   -> MoveOnlyDynamicArray<TypedClass<double>>
+//   MoveOnlyTypedClass{1.5}        -> TypedClass<double, MoveOnlyPolicy>
+
+#include "dynamicArray.hpp"
+#include "typedClass.hpp"
+
+#include <cstddef>
+#include <initializer_list>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+// A TypedClass policy that removes the copy constructor and copy assignment
+struct MoveOnlyPolicy : SilentPolicy {
+  static constexpr bool copyable = false;
+};
+
+template <class T> using MoveOnlyTypedClass = TypedClass<T, MoveOnlyPolicy>;
+
+// A DynamicArray that can be moved but not copied. It is privately a
+// DynamicArray, so it can't be sliced into a copyable one by accident either.
+template <class T> class MoveOnlyDynamicArray : private DynamicArray<T> {
+  using Base = DynamicArray<T>;
+
+public:
+  using Base::Base;
+  // Declared rather than inherited: CTAD from a braced list only looks at
+  // initializer-list constructors the class declares itself
+  constexpr MoveOnlyDynamicArray(std::initializer_list<T> init) : Base(init) {}
+
+  // Adopts an existing array's buffer, and gives it back
+  explicit constexpr MoveOnlyDynamicArray(Base &&arr) : Base(std::move(arr)) {}
+  constexpr Base release() && { return Base(std::move(*this)); }
+
+  MoveOnlyDynamicArray(const MoveOnlyDynamicArray &) = delete;
+  MoveOnlyDynamicArray &operator=(const MoveOnlyDynamicArray &) = delete;
+  constexpr MoveOnlyDynamicArray(MoveOnlyDynamicArray &&) noexcept = default;
+  constexpr MoveOnlyDynamicArray &
+  operator=(MoveOnlyDynamicArray &&) noexcept = default;
+
+  // The only way to copy: element-wise, using each element's clone() when
+  // the elements are move-only themselves
+  constexpr MoveOnlyDynamicArray clone() const {
+    MoveOnlyDynamicArray c;
+    if constexpr (std::is_copy_constructible_v<T>) {
+      static_cast<Base &>(c) = *this; // not getArr(): keeps the accounting
+    } else {
+      c.reserve(this->size());
+      for (const auto &e : *this)
+        c.push_back(e.clone());
+    }
+    return c;
+  }
+
+  using Base::begin;
+  using Base::data;
+  using Base::emplace_back;
+  using Base::empty;
+  using Base::end;
+  using Base::push_back;
+  using Base::reserve;
+  using Base::size;
+  using Base::operator[];
+
+  // A view of the elements. Not DynamicArray's vector reference, which
+  // `auto v = a.getArr();` would quietly copy.
+  constexpr std::span<T> getArr() { return {this->data(), this->size()}; }
+  constexpr std::span<const T> getArr() const {
+    return {this->data(), this->size()};
+  }
+};
+
+// Inherited constructors don't take part in CTAD, so repeat DynamicArray's
+// deduction guide here
+template <class T>
+MoveOnlyDynamicArray(size_t, T) -> MoveOnlyDynamicArray<TypedClass<T>>;
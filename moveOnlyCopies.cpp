@@ -0,0 +1,27 @@
+/*
+ * NOTE: Copies that must not compile
+ * Built only by the moveOnlyCopy* tests. With COPY_ARRAY or COPY_ELEMENT
+ * defined it copies a move-only type, and the test passes when that build
+ * fails; without either it only clones, and that build has to succeed, so
+ * the failures can't come from anything else in here.
+ */
+
+#include "moveOnly.hpp"
+
+#include <utility>
+
+int main() {
+  MoveOnlyDynamicArray a{1, 2, 3};
+  MoveOnlyTypedClass<double> x{1.5};
+#if defined(COPY_ARRAY)
+  MoveOnlyDynamicArray b = a;
+#else
+  MoveOnlyDynamicArray b = a.clone();
+#endif
+#if defined(COPY_ELEMENT)
+  MoveOnlyTypedClass<double> y = x;
+#else
+  MoveOnlyTypedClass<double> y = x.clone();
+#endif
+  return int(b.size()) - 3 + int(y.getData() != 1.5);
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+// Hardware performance counters via Linux perf_event_open(2).
+//
+// Throughput alone doesn't say whether a DynamicArray scan is limited by
+// the cache, the TLB or branch prediction; these counters do:
+//
+//   PerfCounters counters;          // opens and starts the counters
+//   PerfSample sample;
+//   {
+//     PerfScope scope(counters, sample);
+//     for (const auto &e : arr) sum += e.getData();
+//   }
+//   sample[PerfEvent::LLCMisses]    // misses inside the scope only
+//
+// Counting is per thread (the one that created the PerfCounters) and user
+// space only. Counters that can't be opened (no PMU in a VM, seccomp,
+// perf_event_paranoid > 2, ...) are simply reported as unavailable;
+// available() is false when none could be opened, and error() says why.
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#ifdef __linux__
+#include <asm/unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+enum class PerfEvent {
+  Cycles,
+  Instructions,
+  L1DMisses,
+  LLCMisses,
+  BranchMisses,
+  DTLBMisses,
+};
+inline constexpr std::size_t kPerfEvents = 6;
+
+inline const char *perfEventName(PerfEvent e) {
+  static const char *names[kPerfEvents] = {
+      "cycles", "instructions", "L1D-misses",
+      "LLC-misses", "branch-misses", "dTLB-misses"};
+  return names[static_cast<std::size_t>(e)];
+}
+
+// Counter values, scaled up when the kernel had to multiplex them
+struct PerfSample {
+  std::array<double, kPerfEvents> values{};
+  std::array<bool, kPerfEvents> valid{};
+
+  double operator[](PerfEvent e) const {
+    return values[static_cast<std::size_t>(e)];
+  }
+  bool has(PerfEvent e) const { return valid[static_cast<std::size_t>(e)]; }
+
+  PerfSample &operator+=(const PerfSample &o) {
+    for (std::size_t i = 0; i < kPerfEvents; ++i) {
+      values[i] += o.values[i];
+      valid[i] = o.valid[i];
+    }
+    return *this;
+  }
+  PerfSample operator-(const PerfSample &o) const {
+    PerfSample d;
+    for (std::size_t i = 0; i < kPerfEvents; ++i) {
+      d.values[i] = values[i] - o.values[i];
+      d.valid[i] = valid[i] && o.valid[i];
+    }
+    return d;
+  }
+};
+
+#ifdef __linux__
+
+class PerfCounters {
+  int leader = -1;
+  std::array<int, kPerfEvents> fds;
+  std::array<uint64_t, kPerfEvents> ids{};
+  std::string why;
+
+  static int open(uint32_t type, uint64_t config, int group) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = group == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_ID |
+                       PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, group, 0));
+  }
+
+  static constexpr uint64_t cacheMiss(uint64_t cache) {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+           (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+public:
+  PerfCounters() {
+    fds.fill(-1);
+    const std::pair<uint32_t, uint64_t> events[kPerfEvents] = {
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_L1D)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+        {PERF_TYPE_HW_CACHE, cacheMiss(PERF_COUNT_HW_CACHE_DTLB)},
+    };
+    for (std::size_t i = 0; i < kPerfEvents; ++i) {
+      int fd = open(events[i].first, events[i].second, leader);
+      if (fd < 0) {
+        if (why.empty())
+          why = std::string("perf_event_open(") +
+                perfEventName(PerfEvent(i)) + "): " + std::strerror(errno);
+        continue;
+      }
+      fds[i] = fd;
+      ioctl(fd, PERF_EVENT_IOC_ID, &ids[i]);
+      if (leader == -1)
+        leader = fd;
+    }
+    if (leader != -1) {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+  ~PerfCounters() {
+    for (int fd : fds)
+      if (fd != -1)
+        close(fd);
+  }
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  bool available() const { return leader != -1; }
+  // Why the first counter that failed to open did so; empty if none failed
+  const std::string &error() const { return why; }
+
+  // Current totals since construction. One read(2) for the whole group.
+  PerfSample read() const {
+    PerfSample s;
+    if (leader == -1)
+      return s;
+    uint64_t buf[3 + 2 * kPerfEvents];
+    if (::read(leader, buf, sizeof buf) < 0)
+      return s;
+    uint64_t n = buf[0], enabled = buf[1], running = buf[2];
+    double scale = running ? double(enabled) / double(running) : 0.0;
+    for (uint64_t k = 0; k < n; ++k)
+      for (std::size_t i = 0; i < kPerfEvents; ++i)
+        if (fds[i] != -1 && ids[i] == buf[4 + 2 * k]) {
+          s.values[i] = double(buf[3 + 2 * k]) * scale;
+          s.valid[i] = running != 0;
+        }
+    return s;
+  }
+};
+
+#else
+
+// No perf_event_open: every counter is unavailable
+class PerfCounters {
+public:
+  bool available() const { return false; }
+  const std::string &error() const {
+    static const std::string why = "perf counters need Linux";
+    return why;
+  }
+  PerfSample read() const { return {}; }
+};
+
+#endif
+
+// Adds the counts accumulated during its lifetime to `into`
+class PerfScope {
+  const PerfCounters &counters;
+  PerfSample &into;
+  PerfSample start;
+
+public:
+  PerfScope(const PerfCounters &c, PerfSample &into)
+      : counters(c), into(into), start(c.read()) {}
+  ~PerfScope() { into += counters.read() - start; }
+  PerfScope(const PerfScope &) = delete;
+  PerfScope &operator=(const PerfScope &) = delete;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+// USDT (SystemTap-style) static tracepoints.
+//
+//   TRACE_PROBE(dynamicarray, grow, this, oldData, newData, bytes);
+//
+// compiles to a single nop, plus a note in the .note.stapsdt section that
+// tells tracers where the nop is and where to find each argument (a
+// register or a stack slot; nothing is copied for the probe's sake). Tools
+// that read those notes can then patch the nop into a breakpoint at run
+// time, with no rebuild and no restart:
+//
+//   bpftrace -e 'usdt:./containerWorkloadBench:dynamicarray:grow
+//                { @bytes = hist(arg3); }'
+//   bpftrace -l 'usdt:./main:*'            # lists every probe
+//
+// The notes use the same layout <sys/sdt.h> emits, written out here so
+// there is no dependency on systemtap headers. Probes take up to four
+// integer, enum or pointer arguments. They are emitted on x86-64 and
+// AArch64 ELF targets; elsewhere, or with INTERESTING_NO_PROBES defined
+// (cmake -DENABLE_PROBES=OFF), TRACE_PROBE expands to nothing and
+// TRACE_PROBES_ENABLED is 0.
+
+#include <cstdint>
+#include <type_traits>
+
+#if !defined(INTERESTING_NO_PROBES) && defined(__ELF__) &&                     \
+    (defined(__x86_64__) || defined(__aarch64__))
+#define TRACE_PROBES_ENABLED 1
+#else
+#define TRACE_PROBES_ENABLED 0
+#endif
+
+#if TRACE_PROBES_ENABLED
+
+namespace probes {
+// What the tracer reads: enums as their underlying type, pointers as
+// addresses, everything else as is
+template <class T> inline auto value(const T &x) {
+  if constexpr (std::is_pointer_v<T>)
+    return reinterpret_cast<uintptr_t>(x);
+  else if constexpr (std::is_enum_v<T>)
+    return static_cast<std::underlying_type_t<T>>(x);
+  else {
+    static_assert(std::is_arithmetic_v<T>, "probe arguments must be scalars");
+    return x;
+  }
+}
+
+// The argument size as the note spells it, negative for signed types.
+// Negated once more, because it is printed with the %n operand modifier
+// (which is how an immediate comes out without a '$' on x86).
+template <class T> constexpr int noteSize() {
+  return std::is_signed_v<T> ? int(sizeof(T)) : -int(sizeof(T));
+}
+} // namespace probes
+
+#define TRACE_PROBE_ARG_(n) "%n[s" #n "]@%[a" #n "]"
+#define TRACE_PROBE_OP_(n, x)                                                  \
+  [s##n] "n"(::probes::noteSize<decltype(::probes::value(x))>()),              \
+      [a##n] "nor"(::probes::value(x))
+
+#if defined(__LP64__)
+#define TRACE_PROBE_ADDR_ ".8byte"
+#else
+#define TRACE_PROBE_ADDR_ ".4byte"
+#endif
+
+// The note is put in the same section group as the code ("?"), so a probe
+// in an inline function that the linker drops takes its note with it
+#define TRACE_PROBE_ASM_(provider, name, args, ...)                           \
+  do {                                                                         \
+    if (!std::is_constant_evaluated())                                         \
+      __asm__ __volatile__(                                                    \
+          "990: nop\n"                                                         \
+          ".pushsection .note.stapsdt,\"?\",\"note\"\n"                       \
+          ".balign 4\n"                                                        \
+          ".4byte 992f-991f, 994f-993f, 3\n"                                   \
+          "991: .asciz \"stapsdt\"\n"                                          \
+          "992: .balign 4\n"                                                   \
+          "993: " TRACE_PROBE_ADDR_ " 990b\n"                                  \
+          TRACE_PROBE_ADDR_ " _.stapsdt.base\n"                                \
+          TRACE_PROBE_ADDR_ " 0\n" /* no semaphore */                          \
+          ".asciz \"" #provider "\"\n"                                         \
+          ".asciz \"" #name "\"\n"                                             \
+          ".asciz \"" args "\"\n"                                              \
+          "994: .balign 4\n"                                                   \
+          ".popsection\n"                                                      \
+          ".ifndef _.stapsdt.base\n"                                           \
+          ".pushsection .stapsdt.base,\"aG\",\"progbits\",.stapsdt.base,comdat\n" \
+          ".weak _.stapsdt.base\n"                                             \
+          ".hidden _.stapsdt.base\n"                                           \
+          "_.stapsdt.base: .space 1\n"                                         \
+          ".size _.stapsdt.base, 1\n"                                          \
+          ".popsection\n"                                                      \
+          ".endif\n"                                                           \
+          :                                                                    \
+          : __VA_ARGS__);                                                      \
+  } while (0)
+
+#define TRACE_PROBE_0_(p, n) TRACE_PROBE_ASM_(p, n, "", )
+#define TRACE_PROBE_1_(p, n, a) TRACE_PROBE_ASM_(p, n, TRACE_PROBE_ARG_(0), TRACE_PROBE_OP_(0, a))
+#define TRACE_PROBE_2_(p, n, a, b)                                             \
+  TRACE_PROBE_ASM_(p, n, TRACE_PROBE_ARG_(0) " " TRACE_PROBE_ARG_(1),          \
+                   TRACE_PROBE_OP_(0, a), TRACE_PROBE_OP_(1, b))
+#define TRACE_PROBE_3_(p, n, a, b, c)                                          \
+  TRACE_PROBE_ASM_(p, n,                                                       \
+                   TRACE_PROBE_ARG_(0) " " TRACE_PROBE_ARG_(1) " "             \
+                       TRACE_PROBE_ARG_(2),                                    \
+                   TRACE_PROBE_OP_(0, a), TRACE_PROBE_OP_(1, b),               \
+                   TRACE_PROBE_OP_(2, c))
+#define TRACE_PROBE_4_(p, n, a, b, c, d)                                       \
+  TRACE_PROBE_ASM_(p, n,                                                       \
+                   TRACE_PROBE_ARG_(0) " " TRACE_PROBE_ARG_(1) " "             \
+                       TRACE_PROBE_ARG_(2) " " TRACE_PROBE_ARG_(3),            \
+                   TRACE_PROBE_OP_(0, a), TRACE_PROBE_OP_(1, b),               \
+                   TRACE_PROBE_OP_(2, c), TRACE_PROBE_OP_(3, d))
+
+#define TRACE_PROBE_PICK_(_0, _1, _2, _3, _4, which, ...) which
+#define TRACE_PROBE(provider, name, ...)                                       \
+  TRACE_PROBE_PICK_(_ __VA_OPT__(, ) __VA_ARGS__, TRACE_PROBE_4_,              \
+                    TRACE_PROBE_3_, TRACE_PROBE_2_, TRACE_PROBE_1_,            \
+                    TRACE_PROBE_0_)                                            \
+  (provider, name __VA_OPT__(, ) __VA_ARGS__)
+
+#else
+
+#define TRACE_PROBE(provider, name, ...) ((void)0)
+
+#endif
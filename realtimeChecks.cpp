@@ -0,0 +1,99 @@
+// Checks RealtimeDynamicArray's promise with the allocation hooks of
+// allocTracker.cpp: a scripted workload runs once to warm up, the arrays
+// are frozen, and then a thousand more rounds of it must allocate nothing.
+// Exits non-zero on any failure.
+
+#include "allocTracker.hpp"
+#include "realtimeDynamicArray.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <new>
+
+using Price = TypedClass<double, SilentPolicy>;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+  std::printf("%s: %s\n", ok ? "ok" : "FAILED", what);
+  failures += !ok;
+}
+
+// A stand-in for a latency-sensitive thread's loop: fill a window of
+// prices, trim it, average it, snapshot it, and start again
+template <class Array> static double round(Array &window, Array &snapshot) {
+  double sum = 0;
+  for (int i = 0; i < 512; ++i)
+    (void)window.push_back(Price(i * 0.5));
+  for (int i = 0; i < 64; ++i)
+    window.pop_back();
+  (void)window.emplace_back(1.0);
+  for (size_t i = 0; i < window.size(); ++i)
+    sum += window[i].getData();
+  (void)snapshot.assign(window);
+  (void)window.resize(256);
+  window.clear();
+  return sum + double(snapshot.size());
+}
+
+int main() {
+  if (!allocTrackingAvailable()) {
+    std::printf("allocTracker.cpp isn't linked in; nothing to check with\n");
+    return 1;
+  }
+
+  RealtimeDynamicArray<Price> window, snapshot;
+  double warm = round(window, snapshot); // warm-up: allocations allowed
+  window.freeze();
+  snapshot.freeze();
+
+  double total = 0;
+  {
+    AllocScope scope;
+    for (int i = 0; i < 1000; ++i)
+      total += round(window, snapshot);
+    check(scope.allocations() == 0 && scope.bytes() == 0,
+          "1000 rounds after warm-up allocate nothing");
+    check(scope.deallocations() == 0, "... and free nothing");
+  }
+  check(total == 1000 * warm, "every round computed the same result");
+  check(window.refused() == 0 && snapshot.refused() == 0,
+        "nothing was refused within the warmed-up capacity");
+
+  {
+    // A deliberate overflow: refused, reported, and still no allocation
+    RealtimeDynamicArray<Price> full;
+    (void)full.reserve(4);
+    full.freeze(false);
+    AllocScope scope;
+    bool pushed = true;
+    for (int i = 0; i < 5; ++i)
+      pushed = full.push_back(Price(1.0));
+    check(!pushed && full.size() == 4 && full.capacity() == 4,
+          "a push past the frozen capacity is refused, array unchanged");
+    check(!full.reserve(5) && !full.resize(5) && !full.emplace_back(2.0),
+          "reserve, resize and emplace_back past it are refused too");
+    check(full.refused() == 4, "refusals are counted");
+    check(scope.allocations() == 0, "refusing allocates nothing");
+  }
+
+  {
+    // The hooks do see an ordinary DynamicArray growing
+    AllocScope scope;
+    DynamicArray<Price> plain;
+    plain.push_back(Price(1.0));
+    check(scope.allocations() > 0, "a DynamicArray's push_back is counted");
+  }
+
+  {
+    // ...but not an allocation that fails
+    AllocScope scope;
+    volatile size_t huge = SIZE_MAX / 2; // volatile: kept to run time
+    void *p = ::operator new(huge, std::nothrow);
+    check(!p && scope.allocations() == 0 && scope.bytes() == 0,
+          "a failed allocation isn't counted");
+  }
+
+  std::printf("%d check(s) failed\n", failures);
+  return failures != 0;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+// A DynamicArray for threads that mustn't touch the heap once they're up.
+//
+// A RealtimeDynamicArray<T> allocates like any DynamicArray while it warms
+// up. freeze() fixes its capacity: from then on an operation that would
+// need a bigger buffer is refused instead, returning false (or nullptr)
+// and leaving the array as it was. In debug builds a refusal also trips an
+// assert, unless freeze(false) asked for the error alone:
+//
+//   RealtimeDynamicArray<TypedClass<double, SilentPolicy>> prices;
+//   prices.reserve(4096);           // warm-up: room for the worst case
+//   prices.freeze();
+//   if (!prices.push_back(p))       // steady state: never allocates
+//     dropUpdate(p);
+//
+// Within the capacity, insertions, pop_back(), clear() and resize() never
+// allocate; elements whose own constructors allocate (a long std::string)
+// still do, which is up to T. Assignment is replaced by assign(), which
+// can refuse too. realtimeChecks.cpp verifies all this with AllocScope.
+
+#include "dynamicArray.hpp"
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+template <class T> class RealtimeDynamicArray : public DynamicArray<T> {
+  using Base = DynamicArray<T>;
+
+#ifdef NDEBUG
+  static constexpr bool kDebug = false;
+#else
+  static constexpr bool kDebug = true;
+#endif
+
+  bool isFrozen = false;
+  bool assertOnRefusal = false;
+  uint64_t refusals = 0;
+
+  // Whether the buffer may grow to hold n elements
+  bool fits(size_t n) {
+    if (!isFrozen || n <= this->getArr().capacity())
+      return true;
+    ++refusals;
+    assert(!assertOnRefusal && "RealtimeDynamicArray would have allocated");
+    return false;
+  }
+
+public:
+  using Base::Base;
+  RealtimeDynamicArray() = default;
+  // A copy is a new array, warming up like any other
+  RealtimeDynamicArray(const RealtimeDynamicArray &o) : Base(o) {}
+  RealtimeDynamicArray(RealtimeDynamicArray &&) noexcept = default;
+  RealtimeDynamicArray &operator=(const RealtimeDynamicArray &) = delete;
+  RealtimeDynamicArray &operator=(RealtimeDynamicArray &&) = delete;
+
+  void freeze(bool assertOnRefusal = kDebug) {
+    isFrozen = true;
+    this->assertOnRefusal = assertOnRefusal;
+  }
+  void thaw() { isFrozen = false; }
+  bool frozen() const { return isFrozen; }
+  size_t capacity() const { return this->getArr().capacity(); }
+  uint64_t refused() const { return refusals; }
+
+  [[nodiscard]] bool reserve(size_t n) {
+    if (!fits(n))
+      return false;
+    Base::reserve(n);
+    return true;
+  }
+  [[nodiscard]] bool push_back(const T &x) {
+    if (!fits(this->size() + 1))
+      return false;
+    Base::push_back(x);
+    return true;
+  }
+  [[nodiscard]] bool push_back(T &&x) {
+    if (!fits(this->size() + 1))
+      return false;
+    Base::push_back(std::move(x));
+    return true;
+  }
+  template <class... Args> [[nodiscard]] T *emplace_back(Args &&...args) {
+    if (!fits(this->size() + 1))
+      return nullptr;
+    return &Base::emplace_back(std::forward<Args>(args)...);
+  }
+  [[nodiscard]] bool resize(size_t n) {
+    if (!fits(n))
+      return false;
+    Base::reserve(n); // grows through DynamicArray, so the probes see it
+    this->getArr().resize(n);
+    return true;
+  }
+  // Copies o's elements into the existing buffer if they fit
+  [[nodiscard]] bool assign(const Base &o) {
+    if (!fits(o.size()))
+      return false;
+    Base::operator=(o);
+    return true;
+  }
+
+  void pop_back() { this->getArr().pop_back(); }
+  void clear() { this->getArr().clear(); }
+};
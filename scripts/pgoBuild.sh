@@ -0,0 +1,81 @@
+#!/usr/bin/env bash
+# Profile-guided build of the benchmarks, and a report of what it bought.
+#
+#   scripts/pgoBuild.sh [work-dir]      (default: build-pgo)
+#
+# 1. builds a plain -O2 baseline in <work-dir>/o2
+# 2. builds instrumented binaries (PGO=GENERATE) in <work-dir>/pgo
+# 3. trains them on bench/containerWorkloadBench, the representative
+#    DynamicArray/TypedClass workload
+# 4. merges the raw profiles (Clang only; GCC's .gcda files need no merging)
+# 5. rebuilds <work-dir>/pgo with PGO=USE, also at -O2
+# 6. runs the workload on both builds and writes <work-dir>/pgo-report.txt
+#
+# The instrumented and optimized builds share a build directory on purpose:
+# GCC names profiles after the object file's path, so they have to match.
+#
+# Environment: CXX picks the compiler, JOBS the build parallelism,
+# TRAIN_MIN_TIME and MIN_TIME the per-benchmark time of the training and
+# measurement runs (seconds), FILTER a regex restricting the benchmarks.
+#
+# Sampling-based AutoFDO would replace steps 2-4 with `perf record` on an
+# ordinary build plus create_gcov/llvm-profgen; it is not wired up here.
+
+set -euo pipefail
+
+src=$(cd "$(dirname "$0")/.." && pwd)
+work=$(mkdir -p "${1:-build-pgo}" && cd "${1:-build-pgo}" && pwd)
+jobs=${JOBS:-$(nproc)}
+bench=containerWorkloadBench
+filter=${FILTER:-.}
+profiles=$work/profiles
+
+# Both builds use the same optimization level so the only difference is PGO
+common=(-DCMAKE_BUILD_TYPE=Release "-DCMAKE_CXX_FLAGS_RELEASE=-O2 -DNDEBUG")
+
+echo "== baseline -O2 build"
+cmake -S "$src" -B "$work/o2" "${common[@]}" -DPGO=OFF >/dev/null
+cmake --build "$work/o2" --target $bench -j "$jobs" >/dev/null
+
+echo "== instrumented build"
+rm -rf "$profiles"
+cmake -S "$src" -B "$work/pgo" "${common[@]}" -DPGO=GENERATE \
+  "-DPGO_PROFILE_DIR=$profiles" >/dev/null
+cmake --build "$work/pgo" --target $bench -j "$jobs" >/dev/null
+
+echo "== training"
+"$work/pgo/$bench" --min-time="${TRAIN_MIN_TIME:-0.1}" >/dev/null
+
+if compgen -G "$profiles/*.profraw" >/dev/null; then
+  echo "== merging profiles"
+  llvm-profdata merge -o "$profiles/merged.profdata" "$profiles"/*.profraw
+fi
+
+echo "== optimized build"
+cmake -S "$src" -B "$work/pgo" "${common[@]}" -DPGO=USE \
+  "-DPGO_PROFILE_DIR=$profiles" >/dev/null
+cmake --build "$work/pgo" --target $bench -j "$jobs" >/dev/null
+
+echo "== measuring"
+run() {
+  "$1/$bench" --min-time="${MIN_TIME:-0.5}" --filter="$filter" --format=csv |
+    awk -F'"' 'NR > 1 { split($3, f, ","); print $2 "\t" f[3] }'
+}
+run "$work/o2" >"$work/o2.tsv"
+run "$work/pgo" >"$work/pgo.tsv"
+
+awk -F'\t' '
+  NR == FNR { base[$1] = $2; order[++n] = $1; next }
+  { pgo[$1] = $2 }
+  END {
+    printf "%-36s %14s %14s %9s\n", "Benchmark", "-O2 ns/iter", "PGO ns/iter", "speedup"
+    logsum = 0; m = 0
+    for (i = 1; i <= n; i++) {
+      k = order[i]
+      if (!(k in pgo) || pgo[k] <= 0) continue
+      s = base[k] / pgo[k]
+      printf "%-36s %14.1f %14.1f %8.2fx\n", k, base[k], pgo[k], s
+      logsum += log(s); m++
+    }
+    if (m) printf "\ngeometric mean speedup over %d benchmarks: %.3fx\n", m, exp(logsum / m)
+  }' "$work/o2.tsv" "$work/pgo.tsv" | tee "$work/pgo-report.txt"
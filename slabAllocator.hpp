@@ -0,0 +1,218 @@
+#pragma once
+
+// Per-type slab allocation for objects created one at a time, such as
+// individually heap-allocated TypedClass instances.
+//
+// slabAllocator<T>() carves 64KB slabs into slots of exactly sizeof(T)
+// (rounded up to alignof(T), and to at least a pointer) and keeps freed
+// slots on an intrusive free list, so there's no per-object header and no
+// size-class rounding. Slots are carved from the newest slab as they're
+// needed, not all at once.
+//
+//   PoolPtr<TypedClass<double, SilentPolicy>> p =
+//       makePooled<TypedClass<double, SilentPolicy>>(10.34);
+//   p->getData();
+//   // destroyed and its slot freed when p goes away
+//
+// The shared free list is behind a mutex. With ThreadCache (the default),
+// each thread also keeps up to kCached free slots of its own, moving half of
+// them to or from the shared list in one locked step when it runs over or
+// out, so most allocations and frees don't touch the lock at all. A slot
+// freed on another thread simply joins that thread's cache.
+//
+// Slabs are never given back: the allocator holds the high-water mark of
+// each type, and outlives everything (it's never destroyed), so pointers
+// with static storage can still be freed at exit.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+template <class T, bool ThreadCache = true> class SlabAllocator {
+public:
+  static constexpr size_t kAlign = std::max(alignof(T), alignof(void *));
+  static constexpr size_t kSlot =
+      (std::max(sizeof(T), sizeof(void *)) + kAlign - 1) / kAlign * kAlign;
+  static constexpr size_t kSlabBytes = std::max<size_t>(size_t(64) << 10, kSlot);
+  static constexpr size_t kPerSlab = kSlabBytes / kSlot;
+  static constexpr unsigned kCached = 64;
+
+  // Storage for one T
+  void *allocate() {
+    if constexpr (ThreadCache) {
+      Cache *c = cache();
+      if (c && c->count) [[likely]]
+        return c->slots[--c->count];
+      if (c)
+        return refill(*c);
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    return take();
+  }
+
+  void deallocate(void *p) {
+    if constexpr (ThreadCache) {
+      Cache *c = cache();
+      if (c) [[likely]] {
+        if (c->count == kCached) [[unlikely]]
+          spill(*c, kCached / 2);
+        c->slots[c->count++] = p;
+        return;
+      }
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    give(p);
+  }
+
+  // Slots out of the shared list: in use, or waiting in a thread's cache
+  size_t outstanding() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return handedOut;
+  }
+  // Memory set aside for T so far
+  size_t reservedBytes() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return slabs.size() * kSlabBytes;
+  }
+
+private:
+  struct FreeSlot {
+    FreeSlot *next;
+  };
+
+  mutable std::mutex lock;
+  FreeSlot *freeList = nullptr;
+  std::vector<void *> slabs;
+  char *bump = nullptr; // uncarved part of the newest slab
+  char *bumpEnd = nullptr;
+  size_t handedOut = 0;
+
+  // Under the lock
+  void *take() {
+    void *p;
+    if (FreeSlot *s = freeList) {
+      freeList = s->next;
+      p = s;
+    } else {
+      if (bump == bumpEnd)
+        newSlab();
+      p = bump;
+      bump += kSlot;
+    }
+    ++handedOut; // only now: newSlab() may have thrown
+    return p;
+  }
+  void newSlab() {
+    slabs.reserve(slabs.size() + 1); // before there's a slab to leak
+    bump = static_cast<char *>(
+        ::operator new(kSlabBytes, std::align_val_t(kAlign)));
+    bumpEnd = bump + kPerSlab * kSlot;
+    slabs.push_back(bump);
+  }
+  void give(void *p) {
+    --handedOut;
+    freeList = new (p) FreeSlot{freeList};
+  }
+
+  // Per thread and per allocator type; trivial, so it's usable at any
+  // point in the thread's life, like bufferPool's
+  struct Cache {
+    void *slots[kCached];
+    unsigned count;
+    bool flushing;
+    bool closed;
+  };
+  static inline thread_local constinit Cache tls{};
+
+  struct Flusher {
+    SlabAllocator *owner;
+    ~Flusher() {
+      owner->spill(tls, tls.count);
+      tls.closed = true;
+    }
+  };
+
+  Cache *cache() {
+    Cache &c = tls;
+    if (!c.flushing) [[unlikely]] {
+      static thread_local Flusher flusher{this};
+      (void)flusher;
+      c.flushing = true;
+    }
+    return c.closed ? nullptr : &c;
+  }
+
+  // Takes half a cache's worth from the shared list, returning one
+  void *refill(Cache &c) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (unsigned i = 0; i < kCached / 2; ++i)
+      c.slots[c.count++] = take();
+    return c.slots[--c.count];
+  }
+  // Hands the top n of a cache back to the shared list
+  void spill(Cache &c, unsigned n) {
+    std::lock_guard<std::mutex> guard(lock);
+    for (unsigned i = 0; i < n; ++i)
+      give(c.slots[--c.count]);
+  }
+
+  template <class U, bool C> friend SlabAllocator<U, C> &slabAllocator();
+  SlabAllocator() = default;
+};
+
+// The one allocator of T, never destroyed
+template <class T, bool ThreadCache = true>
+SlabAllocator<T, ThreadCache> &slabAllocator() {
+  static auto *allocator = new SlabAllocator<T, ThreadCache>;
+  return *allocator;
+}
+
+// Sole owner of a T in a slab slot, like a std::unique_ptr
+template <class T, bool ThreadCache = true> class PoolPtr {
+  T *p = nullptr;
+
+  explicit PoolPtr(T *p) : p(p) {}
+  template <class U, bool C, class... Args>
+  friend PoolPtr<U, C> makePooled(Args &&...args);
+
+public:
+  PoolPtr() = default;
+  PoolPtr(PoolPtr &&o) noexcept : p(std::exchange(o.p, nullptr)) {}
+  PoolPtr &operator=(PoolPtr &&o) noexcept {
+    if (&o != this) {
+      reset();
+      p = std::exchange(o.p, nullptr);
+    }
+    return *this;
+  }
+  ~PoolPtr() { reset(); }
+
+  void reset() {
+    if (T *q = std::exchange(p, nullptr)) {
+      std::destroy_at(q);
+      slabAllocator<T, ThreadCache>().deallocate(q);
+    }
+  }
+
+  T *get() const { return p; }
+  T &operator*() const { return *p; }
+  T *operator->() const { return p; }
+  explicit operator bool() const { return p != nullptr; }
+};
+
+template <class T, bool ThreadCache = true, class... Args>
+PoolPtr<T, ThreadCache> makePooled(Args &&...args) {
+  auto &allocator = slabAllocator<T, ThreadCache>();
+  void *slot = allocator.allocate();
+  try {
+    return PoolPtr<T, ThreadCache>(new (slot) T(std::forward<Args>(args)...));
+  } catch (...) {
+    allocator.deallocate(slot);
+    throw;
+  }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+// Objects addressed by Id<T> handles (typeUtils.hpp) and stored densely.
+//
+// A SlotMap<T> keeps its elements packed at the front of a DynamicArray<T>,
+// in no particular order, so going through all of them is a walk over
+// contiguous memory. An Id<T> names a slot instead of a position: the slot
+// records where its element currently is, and a generation that goes up
+// each time the slot's element is erased. Insertion, erasure and lookup
+// are O(1), and a handle whose element is gone is detected rather than
+// aliasing the element that reused its slot:
+//
+//   SlotMap<TypedClass<double, SilentPolicy>> prices;
+//   Id<TypedClass<double, SilentPolicy>> id = prices.insert(10.34);
+//   prices.find(id)->getData();   // 10.34
+//   prices.erase(id);
+//   prices.find(id);              // nullptr, even once the slot is reused
+//   for (auto &p : prices) ...    // the live elements, densely
+//
+// Erasure moves the last element into the hole, so pointers from find()
+// and the dense order only last until the next erase(); Ids are stable.
+// Freed slots are reused most recently freed first; a slot whose
+// generation would wrap around is retired instead.
+
+#include "dynamicArray.hpp"
+#include "typeUtils.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+
+template <class T> class SlotMap {
+public:
+  using Handle = Id<T>;
+
+  size_t size() const { return values.size(); }
+  bool empty() const { return values.empty(); }
+
+  // args may refer to an element of the map
+  template <class... Args> Handle emplace(Args &&...args) {
+    if (freeHead == kNone) {
+      if (slots.size() == kNone)
+        throw std::length_error("SlotMap: out of slots");
+      slots.push_back({kNone, 1});
+      freeHead = uint32_t(slots.size() - 1);
+    }
+    uint32_t index = freeHead;
+    owners.push_back(index);
+    try {
+      values.emplace_back(std::forward<Args>(args)...);
+    } catch (...) {
+      owners.getArr().pop_back();
+      throw;
+    }
+    Slot &s = slots[index];
+    freeHead = s.link;
+    s.link = uint32_t(values.size() - 1);
+    return {index, s.generation};
+  }
+  Handle insert(const T &x) { return emplace(x); }
+  Handle insert(T &&x) { return emplace(std::move(x)); }
+
+  // nullptr if id's element has been erased, or id is from another map
+  T *find(Handle id) {
+    return live(id) ? &values[slots[id.idx].link] : nullptr;
+  }
+  const T *find(Handle id) const {
+    return live(id) ? &values[slots[id.idx].link] : nullptr;
+  }
+  bool contains(Handle id) const { return live(id); }
+
+  // false if id's element was already gone
+  bool erase(Handle id) {
+    if (!live(id))
+      return false;
+    Slot &s = slots[id.idx];
+    uint32_t hole = s.link;
+    uint32_t last = uint32_t(values.size() - 1);
+    if (hole != last) {
+      values[hole] = std::move(values[last]);
+      owners[hole] = owners[last];
+      slots[owners[hole]].link = hole;
+    }
+    values.getArr().pop_back();
+    owners.getArr().pop_back();
+    if (++s.generation != 0) {
+      s.link = freeHead;
+      freeHead = id.idx;
+    } // else retired: never handed out again
+    return true;
+  }
+
+  void clear() {
+    for (size_t i = values.size(); i-- > 0;)
+      erase({owners[i], slots[owners[i]].generation});
+  }
+
+  // The Id of the element at position i of the dense order
+  Handle idAt(size_t i) const {
+    return {owners[i], slots[owners[i]].generation};
+  }
+
+  T *data() { return values.data(); }
+  const T *data() const { return values.data(); }
+  T *begin() { return values.data(); }
+  T *end() { return values.data() + values.size(); }
+  const T *begin() const { return values.data(); }
+  const T *end() const { return values.data() + values.size(); }
+
+private:
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  // link: the element's position while the slot is live, the next free
+  // slot while it's free
+  struct Slot {
+    uint32_t link;
+    uint32_t generation;
+  };
+
+  DynamicArray<T> values;
+  DynamicArray<uint32_t> owners; // owners[i]: the slot of values[i]
+  DynamicArray<Slot> slots;
+  uint32_t freeHead = kNone;
+
+  bool live(Handle id) const {
+    if (id.idx >= slots.size())
+      return false;
+    const Slot &s = slots[id.idx];
+    return s.generation == id.gen && s.link < owners.size() &&
+           owners[s.link] == id.idx;
+  }
+};
@@ -0,0 +1,209 @@
+#pragma once
+
+// Bulk, multi-threaded demangling of symbol names (e.g. from ElfFile).
+//
+//   ElfFile elf("main");
+//   StringInterner strings;
+//   DemangledSymbols out = demangleSymbols(elf.symbols(), strings, 4);
+//   // out.names[i] is the readable form of the i-th symbol
+//
+// Each thread keeps its own Demangler and output buffer, so the only shared
+// state is the StringInterner the results go into. Symbols repeat a lot
+// (.symtab and .dynsym overlap, and clones like .cold/.isra demangle to
+// near-identical text), so every distinct string is stored once.
+
+#include "demangle.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// A thread-safe set of strings with stable storage. intern() returns a view
+// that stays valid for the interner's lifetime, and equal strings always
+// come back as the same view. Split into shards with one lock each, so
+// threads interning different strings rarely wait on one another. Each
+// shard is an open-addressing table over bump-allocated blocks: interning
+// a new string costs a copy, never a malloc of its own.
+class StringInterner {
+  static constexpr size_t kShards = 64;
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  struct Slot {
+    size_t hash = 0;
+    std::string_view text; // data() == nullptr: empty slot
+  };
+
+  struct Shard {
+    std::mutex lock;
+    std::vector<Slot> slots;
+    size_t count = 0;
+    std::vector<std::unique_ptr<char[]>> blocks;
+    char *free = nullptr;
+    size_t left = 0;
+    size_t bytes = 0;
+
+    std::string_view store(std::string_view s) {
+      if (s.size() > left) {
+        size_t n = std::max(kBlockSize, s.size());
+        blocks.emplace_back(new char[n]); // not make_unique: no need to zero
+        free = blocks.back().get();
+        left = n;
+      }
+      std::copy(s.begin(), s.end(), free);
+      std::string_view stored(free, s.size());
+      free += s.size();
+      left -= s.size();
+      bytes += s.size();
+      return stored;
+    }
+
+    // Keeps the table at most half full
+    void grow() {
+      std::vector<Slot> old(std::max<size_t>(64, slots.size() * 2));
+      old.swap(slots);
+      for (const Slot &e : old)
+        if (e.text.data())
+          for (size_t i = e.hash;; ++i)
+            if (Slot &to = slots[i & (slots.size() - 1)]; !to.text.data()) {
+              to = e;
+              break;
+            }
+    }
+  };
+  Shard shards[kShards];
+
+public:
+  std::string_view intern(std::string_view s) {
+    if (s.empty())
+      return ""; // a null data() would read as an empty slot
+    size_t hash = std::hash<std::string_view>{}(s);
+    // The low bits pick the slot, so pick the shard with the high ones
+    Shard &shard = shards[(hash >> 32) % kShards];
+    std::lock_guard<std::mutex> guard(shard.lock);
+    if (2 * (shard.count + 1) > shard.slots.size())
+      shard.grow();
+    for (size_t i = hash;; ++i) {
+      Slot &slot = shard.slots[i & (shard.slots.size() - 1)];
+      if (!slot.text.data()) {
+        slot = {hash, shard.store(s)};
+        ++shard.count;
+        return slot.text;
+      }
+      if (slot.hash == hash && slot.text == s)
+        return slot.text;
+    }
+  }
+
+  // Number of distinct strings, and the bytes they take up
+  size_t size() {
+    size_t n = 0;
+    for (Shard &s : shards) {
+      std::lock_guard<std::mutex> guard(s.lock);
+      n += s.count;
+    }
+    return n;
+  }
+  size_t bytes() {
+    size_t n = 0;
+    for (Shard &s : shards) {
+      std::lock_guard<std::mutex> guard(s.lock);
+      n += s.bytes;
+    }
+    return n;
+  }
+};
+
+struct DemangledSymbols {
+  // names[i] is symbols[i] demangled, or symbols[i] itself when it isn't a
+  // C++ name or couldn't be demangled
+  std::vector<std::string_view> names;
+  size_t demangled = 0; // C++ names turned into readable form
+  size_t failed = 0;    // looked like C++ names but didn't demangle
+};
+
+// Demangles `symbols` on `threads` threads (0: one per hardware thread).
+// Threads claim the symbols in batches, so a run of long names doesn't
+// leave one of them behind the rest. A name whose readable form would take
+// more than 1MB counts as failed: it's hostile input, not a real symbol.
+inline DemangledSymbols demangleSymbols(const std::vector<std::string_view> &symbols,
+                                        StringInterner &strings,
+                                        unsigned threads = 0) {
+  constexpr size_t kBatch = 256;
+  constexpr size_t kMaxLength = size_t(1) << 20;
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  threads = static_cast<unsigned>(
+      std::min<size_t>(threads, (symbols.size() + kBatch - 1) / kBatch));
+
+  DemangledSymbols out;
+  out.names.resize(symbols.size());
+  std::atomic<size_t> next{0}, demangled{0}, failed{0};
+
+  auto worker = [&] {
+    std::unique_ptr<Demangler> d(new Demangler); // not zeroed: it's big
+    std::string big; // for the rare name that doesn't fit in buf
+    std::string withVersion;
+    char buf[4096];
+    size_t ok = 0, bad = 0;
+    for (;;) {
+      size_t begin = next.fetch_add(kBatch, std::memory_order_relaxed);
+      if (begin >= symbols.size())
+        break;
+      size_t end = std::min(begin + kBatch, symbols.size());
+      for (size_t i = begin; i < end; ++i) {
+        std::string_view name = symbols[i];
+        out.names[i] = name;
+        if (!name.starts_with("_Z"))
+          continue;
+        // Versioned names from .symtab ("_Znwm@GLIBCXX_3.4") keep their
+        // version, as c++filt does
+        std::string_view version;
+        if (size_t at = name.find('@'); at != std::string_view::npos) {
+          version = name.substr(at);
+          name = name.substr(0, at);
+        }
+        DemangleResult r = d->demangle(name, buf, sizeof buf);
+        std::string_view text(buf, r.length);
+        if (r.status == DemangleStatus::BufferTooSmall) {
+          big.resize(sizeof buf);
+          do {
+            big.resize(big.size() * 2);
+            r = d->demangle(name, big.data(), big.size());
+          } while (r.status == DemangleStatus::BufferTooSmall &&
+                   big.size() < kMaxLength);
+          text = std::string_view(big.data(), r.length);
+        }
+        if (!r) {
+          ++bad;
+          continue;
+        }
+        if (!version.empty()) {
+          withVersion.assign(text).append(version);
+          text = withVersion;
+        }
+        out.names[i] = strings.intern(text);
+        ++ok;
+      }
+    }
+    demangled += ok;
+    failed += bad;
+  };
+
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < threads; ++t)
+    pool.emplace_back(worker);
+  worker(); // the calling thread works too
+  for (auto &t : pool)
+    t.join();
+
+  out.demangled = demangled;
+  out.failed = failed;
+  return out;
+}
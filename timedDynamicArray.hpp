@@ -0,0 +1,107 @@
+#pragma once
+
+// Opt-in latency recording for DynamicArray operations.
+//
+// TimedDynamicArray<T> is a DynamicArray<T> whose constructors, growth
+// (insertions and reserve() calls that reallocate) and copies record how
+// long they took into arrayLatencies(), one histogram per ArrayOp:
+//
+//   TimedDynamicArray<TypedClass<double, SilentPolicy>> a(1000);
+//   a.push_back(x);
+//   ...
+//   arrayLatencies().dump(std::cout); // a line of percentiles per ArrayOp
+//
+// Insertions that fit in the current capacity are not timed, so the
+// common case only pays for the capacity check DynamicArray makes anyway.
+// Calls made through a DynamicArray<T>& go untimed, as do changes made
+// through getArr().
+
+#include "dynamicArray.hpp"
+#include "hdrHistogram.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+enum class ArrayOp { Construct, Grow, Copy };
+
+inline LatencyMetrics &arrayLatencies() {
+  static LatencyMetrics metrics({"construct", "grow", "copy"});
+  return metrics;
+}
+
+template <class T> class TimedDynamicArray : public DynamicArray<T> {
+  using Base = DynamicArray<T>;
+  using Clock = std::chrono::steady_clock;
+
+  static void record(ArrayOp op, Clock::time_point start) {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        Clock::now() - start);
+    arrayLatencies().record(static_cast<size_t>(op), uint64_t(ns.count()));
+  }
+
+  // Every constructor delegates here, so the clock is read before the base
+  // (and with it the buffer) is constructed
+  template <class... Args>
+  TimedDynamicArray(ArrayOp op, Clock::time_point start, Args &&...args)
+      : Base(std::forward<Args>(args)...) {
+    record(op, start);
+  }
+
+  bool full() const {
+    return this->getArr().size() == this->getArr().capacity();
+  }
+
+public:
+  TimedDynamicArray() = default; // allocates nothing, so nothing to time
+  TimedDynamicArray(size_t sz)
+      : TimedDynamicArray(ArrayOp::Construct, Clock::now(), sz) {}
+  TimedDynamicArray(std::initializer_list<T> init)
+      : TimedDynamicArray(ArrayOp::Construct, Clock::now(), init) {}
+  TimedDynamicArray(size_t sz, const T &val)
+      : TimedDynamicArray(ArrayOp::Construct, Clock::now(), sz, val) {}
+
+  TimedDynamicArray(const TimedDynamicArray &o)
+      : TimedDynamicArray(ArrayOp::Copy, Clock::now(),
+                          static_cast<const Base &>(o)) {}
+  TimedDynamicArray(TimedDynamicArray &&) noexcept = default;
+  TimedDynamicArray &operator=(const TimedDynamicArray &o) {
+    auto start = Clock::now();
+    Base::operator=(o);
+    record(ArrayOp::Copy, start);
+    return *this;
+  }
+  TimedDynamicArray &operator=(TimedDynamicArray &&) noexcept = default;
+
+  void reserve(size_t n) {
+    if (n <= this->getArr().capacity())
+      return;
+    auto start = Clock::now();
+    Base::reserve(n);
+    record(ArrayOp::Grow, start);
+  }
+  void push_back(const T &x) {
+    if (!full())
+      return Base::push_back(x);
+    auto start = Clock::now();
+    Base::push_back(x);
+    record(ArrayOp::Grow, start);
+  }
+  void push_back(T &&x) {
+    if (!full())
+      return Base::push_back(std::move(x));
+    auto start = Clock::now();
+    Base::push_back(std::move(x));
+    record(ArrayOp::Grow, start);
+  }
+  template <class... Args> T &emplace_back(Args &&...args) {
+    if (!full())
+      return Base::emplace_back(std::forward<Args>(args)...);
+    auto start = Clock::now();
+    T &e = Base::emplace_back(std::forward<Args>(args)...);
+    record(ArrayOp::Grow, start);
+    return e;
+  }
+};
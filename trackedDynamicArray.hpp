@@ -0,0 +1,272 @@
+#pragma once
+
+// Opt-in accounting of live DynamicArrays: which element types and which
+// allocation sites hold how much memory, and how much of it is slack.
+//
+// TrackedDynamicArray<T> is a DynamicArray<T> that registers itself in
+// arrayRegistry() for its lifetime, tagged with the source location that
+// constructed it:
+//
+//   TrackedDynamicArray<TypedClass<double, SilentPolicy>> a(1000);
+//   a.push_back(x);
+//   ...
+//   arrayRegistry().dumpTop(std::cout, 10); // the 10 biggest type/site pairs
+//
+// Each array keeps its own size and capacity in relaxed atomics, so growing
+// one touches nothing shared. Registering and unregistering lock one of
+// kShards mutexes, picked per thread, so threads creating arrays at the
+// same time rarely meet. Readers lock the shards one at a time; a report
+// is consistent per array, not across the whole registry.
+//
+// Calls made through a DynamicArray<T>& and changes made through getArr()
+// aren't seen until the next call on the TrackedDynamicArray.
+
+#include "demangle.hpp"
+#include "dynamicArray.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <mutex>
+#include <ostream>
+#include <source_location>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// One live array, embedded in it and linked into a registry shard
+struct ArrayRecord {
+  const char *type; // demangled element type
+  size_t elementSize;
+  std::source_location site;
+  std::atomic<size_t> size{0};
+  std::atomic<size_t> capacity{0};
+  ArrayRecord *prev = nullptr;
+  ArrayRecord *next = nullptr;
+  unsigned shard = 0;
+
+  ArrayRecord(const char *type, size_t elementSize, std::source_location site)
+      : type(type), elementSize(elementSize), site(site) {}
+  ArrayRecord(const ArrayRecord &) = delete;
+  ArrayRecord &operator=(const ArrayRecord &) = delete;
+};
+
+class ArrayRegistry {
+public:
+  static constexpr unsigned kShards = 64;
+
+  // The live arrays of one element type constructed at one site
+  struct Usage {
+    const char *type;
+    std::source_location site;
+    size_t arrays = 0;
+    size_t elements = 0; // sum of sizes
+    size_t capacity = 0; // sum of capacities, in elements
+    size_t bytes = 0;    // capacity * sizeof(T)
+    size_t slackBytes = 0;
+  };
+
+  void add(ArrayRecord &r) {
+    r.shard = thisThreadShard();
+    Shard &s = shards[r.shard];
+    std::lock_guard<std::mutex> guard(s.lock);
+    r.next = s.first;
+    if (s.first)
+      s.first->prev = &r;
+    s.first = &r;
+  }
+
+  // May be called from any thread, not only the one that added r
+  void remove(ArrayRecord &r) {
+    Shard &s = shards[r.shard];
+    std::lock_guard<std::mutex> guard(s.lock);
+    (r.prev ? r.prev->next : s.first) = r.next;
+    if (r.next)
+      r.next->prev = r.prev;
+  }
+
+  // top() reads the site under the shard's lock, so it's changed under it
+  void setSite(ArrayRecord &r, std::source_location site) {
+    std::lock_guard<std::mutex> guard(shards[r.shard].lock);
+    r.site = site;
+  }
+
+  // Every type/site pair with live arrays, the most bytes first; at most n
+  // of them
+  std::vector<Usage> top(size_t n = SIZE_MAX) const {
+    struct Key {
+      const char *type, *file;
+      unsigned line, column;
+      bool operator==(const Key &) const = default;
+    };
+    struct Hash {
+      size_t operator()(const Key &k) const {
+        return std::hash<const void *>()(k.type) * 31 +
+               std::hash<const void *>()(k.file) * 7 + k.line * 131 + k.column;
+      }
+    };
+    std::unordered_map<Key, Usage, Hash> bySite;
+    for (const Shard &s : shards) {
+      std::lock_guard<std::mutex> guard(s.lock);
+      for (const ArrayRecord *r = s.first; r; r = r->next) {
+        Usage &u = bySite[{r->type, r->site.file_name(), r->site.line(),
+                           r->site.column()}];
+        size_t size = r->size.load(std::memory_order_relaxed);
+        size_t capacity = r->capacity.load(std::memory_order_relaxed);
+        u.type = r->type;
+        u.site = r->site;
+        u.arrays += 1;
+        u.elements += size;
+        u.capacity += capacity;
+        u.bytes += capacity * r->elementSize;
+        u.slackBytes += (capacity - std::min(size, capacity)) * r->elementSize;
+      }
+    }
+    std::vector<Usage> out;
+    out.reserve(bySite.size());
+    for (auto &[_, u] : bySite)
+      out.push_back(u);
+    std::sort(out.begin(), out.end(), [](const Usage &a, const Usage &b) {
+      return a.bytes != b.bytes ? a.bytes > b.bytes : a.arrays > b.arrays;
+    });
+    if (out.size() > n)
+      out.resize(n);
+    return out;
+  }
+
+  // A totals line, then a line per type/site pair from top(n)
+  void dumpTop(std::ostream &os, size_t n = 10) const {
+    std::vector<Usage> all = top();
+    size_t arrays = 0, bytes = 0, slack = 0;
+    for (const Usage &u : all) {
+      arrays += u.arrays;
+      bytes += u.bytes;
+      slack += u.slackBytes;
+    }
+    char line[512];
+    std::snprintf(line, sizeof line,
+                  "%zu live arrays, %zu bytes, %zu of them slack\n", arrays,
+                  bytes, slack);
+    os << line;
+    for (size_t i = 0; i < all.size() && i < n; ++i) {
+      const Usage &u = all[i];
+      std::snprintf(line, sizeof line,
+                    "%12zu B  %5.1f%% slack  %8zu arrays  %s:%u  %s\n", u.bytes,
+                    u.bytes ? 100.0 * double(u.slackBytes) / double(u.bytes)
+                            : 0.0,
+                    u.arrays, u.site.file_name(), unsigned(u.site.line()),
+                    u.type);
+      os << line;
+    }
+  }
+
+private:
+  struct alignas(64) Shard {
+    mutable std::mutex lock;
+    ArrayRecord *first = nullptr;
+  };
+  Shard shards[kShards];
+
+  // Threads take shards round-robin, so the first kShards threads never
+  // share one
+  static unsigned thisThreadShard() {
+    static std::atomic<unsigned> next{0};
+    static thread_local unsigned shard =
+        next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return shard;
+  }
+};
+
+inline ArrayRegistry &arrayRegistry() {
+  static ArrayRegistry registry;
+  return registry;
+}
+
+template <class T> class TrackedDynamicArray : public DynamicArray<T> {
+  using Base = DynamicArray<T>;
+  using Site = std::source_location;
+
+  ArrayRecord record;
+
+  void refresh() {
+    record.size.store(this->getArr().size(), std::memory_order_relaxed);
+    record.capacity.store(this->getArr().capacity(),
+                          std::memory_order_relaxed);
+  }
+  void enroll() {
+    refresh();
+    arrayRegistry().add(record);
+  }
+
+public:
+  // Every constructor but the move constructor takes the site it's called
+  // from. A copy is tagged where it was made; a move, by construction or
+  // assignment, takes the tag of the array whose buffer it takes, so
+  // relocating arrays (in a std::vector, say) doesn't move their bytes to
+  // the relocation site.
+  TrackedDynamicArray(Site site = Site::current())
+      : record(typeName<T>(), sizeof(T), site) {
+    enroll();
+  }
+  TrackedDynamicArray(size_t sz, Site site = Site::current())
+      : Base(sz), record(typeName<T>(), sizeof(T), site) {
+    enroll();
+  }
+  TrackedDynamicArray(std::initializer_list<T> init,
+                      Site site = Site::current())
+      : Base(init), record(typeName<T>(), sizeof(T), site) {
+    enroll();
+  }
+  TrackedDynamicArray(size_t sz, const T &val, Site site = Site::current())
+      : Base(sz, val), record(typeName<T>(), sizeof(T), site) {
+    enroll();
+  }
+
+  TrackedDynamicArray(const TrackedDynamicArray &o,
+                      Site site = Site::current())
+      : Base(o), record(typeName<T>(), sizeof(T), site) {
+    enroll();
+  }
+  TrackedDynamicArray(TrackedDynamicArray &&o) noexcept
+      : Base(std::move(o)), record(typeName<T>(), sizeof(T), o.record.site) {
+    enroll();
+    o.refresh();
+  }
+  TrackedDynamicArray &operator=(const TrackedDynamicArray &o) {
+    Base::operator=(o);
+    refresh();
+    return *this;
+  }
+  TrackedDynamicArray &operator=(TrackedDynamicArray &&o) noexcept {
+    Base::operator=(std::move(o));
+    arrayRegistry().setSite(record, o.record.site);
+    refresh();
+    o.refresh();
+    return *this;
+  }
+  ~TrackedDynamicArray() { arrayRegistry().remove(record); }
+
+  const std::source_location &site() const { return record.site; }
+
+  void reserve(size_t n) {
+    Base::reserve(n);
+    refresh();
+  }
+  void push_back(const T &x) {
+    Base::push_back(x);
+    refresh();
+  }
+  void push_back(T &&x) {
+    Base::push_back(std::move(x));
+    refresh();
+  }
+  template <class... Args> T &emplace_back(Args &&...args) {
+    T &e = Base::emplace_back(std::forward<Args>(args)...);
+    refresh();
+    return e;
+  }
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <type_traits>
+
+// A compile-time list of types, e.g. TypeList<int, double, Id<float>>.
+// Nothing is ever instantiated from it; it only carries the pack around so
+// that other templates can query it with the helpers below.
+template <class... Ts> struct TypeList {
+  static constexpr std::size_t size = sizeof...(Ts);
+};
+
+// contains_v<T, TypeList<...>>: true if T is one of the listed types
+template <class T, class List> struct Contains;
+template <class T, class... Ts>
+struct Contains<T, TypeList<Ts...>>
+    : std::bool_constant<(std::is_same_v<T, Ts> || ...)> {};
+template <class T, class List>
+inline constexpr bool contains_v = Contains<T, List>::value;
+
+// index_of_v<T, TypeList<...>>: position of the first T in the list
+template <class T, class List> struct IndexOf;
+template <class T, class... Ts> struct IndexOf<T, TypeList<T, Ts...>> {
+  static constexpr std::size_t value = 0;
+};
+template <class T, class U, class... Ts> struct IndexOf<T, TypeList<U, Ts...>> {
+  static_assert(sizeof...(Ts) > 0, "type is not in the TypeList");
+  static constexpr std::size_t value = 1 + IndexOf<T, TypeList<Ts...>>::value;
+};
+template <class T, class List>
+inline constexpr std::size_t index_of_v = IndexOf<T, List>::value;
+
+// Calls f.template operator()<T>() once per listed type, in order.
+// Handy with a templated lambda: forEachType<L>([]<class T>() { ... });
+template <class List> struct ForEachType;
+template <class... Ts> struct ForEachType<TypeList<Ts...>> {
+  template <class F> static constexpr void apply(F &&f) {
+    (f.template operator()<Ts>(), ...);
+  }
+};
+template <class List, class F> constexpr void forEachType(F &&f) {
+  ForEachType<List>::apply(f);
+}
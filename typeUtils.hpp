@@ -0,0 +1,62 @@
+#pragma once
+
+#include "demangle.hpp" // To convert typenames into readable names
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include <type_traits> // Compile time utilities for querying and modifying
+                       // templates, defines std::is_same_v<T1, T2>
+#include <typeinfo>    // For typeid operator and std::type_info class
+
+// A handle to a T in a SlotMap<T> (slotMap.hpp): the index of its slot and
+// the generation the slot was in when the T was put there, so a handle to
+// an erased T is told apart from one to whatever took its slot. A default
+// Id refers to nothing.
+template <class T> class Id {
+public:
+  constexpr Id() = default;
+
+  constexpr uint32_t index() const { return idx; }
+  constexpr uint32_t generation() const { return gen; }
+  constexpr explicit operator bool() const { return gen != 0; }
+  friend constexpr bool operator==(Id, Id) = default;
+
+private:
+  uint32_t idx = 0;
+  uint32_t gen = 0; // 0: no T; live slots start at 1
+
+  constexpr Id(uint32_t index, uint32_t generation)
+      : idx(index), gen(generation) {}
+  template <class> friend class SlotMap;
+};
+
+// A 64-bit id for T, fixed at compile time and the same in every
+// translation unit: an FNV-1a hash of the compiler's name for this
+// function, which spells T out. Never 0, so it can key ConcurrentHashMap.
+template <class T> consteval uint64_t typeId() {
+  uint64_t h = 14695981039346656037ull;
+  for (char c : std::string_view(__PRETTY_FUNCTION__))
+    h = (h ^ uint8_t(c)) * 1099511628211ull;
+  return h ? h : 1;
+}
+
+// Checking actual type at the runtime
+template <typename T> void checkType(const T &) {
+  std::cout << "Type: " << typeid(T).name() << "\n";
+};
+
+template <typename T> void checkTypeDem(const T &) {
+  std::cout << "Demangled Type: " << typeName<T>() << std::endl;
+}
+
+// Compile time checks of types using `if constexpr` and type traits
+template <typename T> void compileTimeTypeCheck(const T &) {
+  if constexpr (std::is_same_v<T, int>)
+    std::cout << "Type at compile time is int" << std::endl;
+  else if constexpr (std::is_same_v<T, double>)
+    std::cout << "Type at compile time is double" << std::endl;
+  else if constexpr (std::is_same_v<T, Id<float>>)
+    std::cout << "Type at compile time is Id<float>" << std::endl;
+  else
+    std::cout << "Type at compile time is something else" << std::endl;
+}
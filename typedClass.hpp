@@ -0,0 +1,153 @@
+#pragma once
+
+#include "demangle.hpp"
+#include "probes.hpp"
+
+#include <iostream>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+
+// Which constructor of a TypedClass ran
+enum class Construction { Default, Value, Copy, Move };
+
+// Selects the constructor a container relocates elements with (see
+// DynamicArray::relocate())
+struct Relocation {};
+
+// TypedClass policies decide what happens when a constructor is invoked,
+// and get to observe the object's value being read, moved away or assigned.
+// SilentPolicy does nothing; it's the one to use for bulk workloads and
+// benchmarks, and the base for other policies that only override some hooks.
+struct SilentPolicy {
+  // false makes TypedClass move-only (see moveOnly.hpp)
+  static constexpr bool copyable = true;
+
+  template <class T> constexpr void constructed(Construction, const T &) {}
+  constexpr void accessed() const {} // the value is about to be read
+  constexpr void movedFrom() {}      // the value was just moved out
+  constexpr void assigned() {}       // a new value was just assigned
+};
+
+// The default policy: prints a message whenever a constructor is invoked.
+struct VerbosePolicy : SilentPolicy {
+  template <class T> void constructed(Construction how, const T &val) {
+    const char *what = how == Construction::Default ? "Default"
+                       : how == Construction::Value ? "Parameterized"
+                       : how == Construction::Copy  ? "Copy"
+                                                    : "Move";
+    std::cout << what << " constructor of TypedClass<"
+              << typeName<T>() << ">";
+    if constexpr (requires { std::cout << val; })
+      if (how == Construction::Copy)
+        std::cout << " with value " << val;
+    std::cout << std::endl;
+  }
+};
+
+// A wrapper class around any type T.
+// Reports constructor invocations to its Policy (prints them by default).
+// Constructors and the destructor also fire typedclass:* probes (see
+// probes.hpp) with the object's address and &typeid(T), so tracers can watch
+// SilentPolicy instances as well; destroy only when T's destructor isn't
+// trivial. The mangled name of T is the pointer right after the type_info's
+// vtable pointer:
+//   bpftrace -e 'usdt:./main:typedclass:copy
+//                { @[str(*(uint64 *)(arg2 + 8))] = count(); }' 
+template <class T, class Policy = VerbosePolicy>
+class TypedClass : private Policy {
+  T val;
+
+public:
+  constexpr TypedClass() : val() {
+    TRACE_PROBE(typedclass, construct, this, Construction::Default, type());
+    this->constructed(Construction::Default, val);
+  }
+  constexpr TypedClass(const T &x) : val(x) {
+    TRACE_PROBE(typedclass, construct, this, Construction::Value, type());
+    this->constructed(Construction::Value, val);
+  }
+  constexpr TypedClass(T &&x) : val(std::move(x)) {
+    TRACE_PROBE(typedclass, construct, this, Construction::Value, type());
+    this->constructed(Construction::Value, val);
+  }
+
+  // Explicit copy constructor: invoked when copying another TypedClass<T>
+  constexpr TypedClass(const TypedClass &obj)
+    requires(Policy::copyable)
+      : val(obj.read()) {
+    TRACE_PROBE(typedclass, copy, this, &obj, type());
+    this->constructed(Construction::Copy, val);
+  }
+
+  // Move constructor: without it, TypedClass(std::move(obj)) would silently
+  // fall back to the copy constructor above
+  constexpr TypedClass(TypedClass &&obj) noexcept(
+      std::is_nothrow_move_constructible_v<T>)
+      : val(std::move(obj.read())) {
+    obj.movedFrom();
+    TRACE_PROBE(typedclass, move, this, &obj, type());
+    this->constructed(Construction::Move, val);
+  }
+
+  // A move that only DynamicArray makes, when it relocates its elements on
+  // growth. The policy sees a move; tracers see dynamicarray:grow for the
+  // whole batch instead of typedclass:move per element, which leaves the
+  // relocation loop nothing opaque and lets the compiler vectorize it.
+  constexpr TypedClass(Relocation, TypedClass &&obj) noexcept(
+      std::is_nothrow_move_constructible_v<T>)
+      : val(std::move(obj.read())) {
+    obj.movedFrom();
+    this->constructed(Construction::Move, val);
+  }
+
+  // No destroy probe when T's destructor is trivial: TypedClass<double>
+  // stays trivially destructible, so destroying a vector of them, or the
+  // old buffer after a reallocation, needs no destructor loop
+  constexpr ~TypedClass()
+    requires(!std::is_trivially_destructible_v<T>)
+  {
+    TRACE_PROBE(typedclass, destroy, this, type());
+  }
+  ~TypedClass() = default;
+
+  constexpr TypedClass &operator=(const TypedClass &obj)
+    requires(Policy::copyable)
+  {
+    val = obj.read();
+    this->assigned();
+    return *this;
+  }
+  constexpr TypedClass &operator=(TypedClass &&obj) noexcept(
+      std::is_nothrow_move_assignable_v<T>) {
+    val = std::move(obj.read());
+    this->assigned();
+    if (&obj != this)
+      obj.movedFrom();
+    return *this;
+  }
+
+  // Getter
+  constexpr T getData() const { return read(); }
+
+  // An explicit copy, for policies that forbid implicit ones
+  constexpr TypedClass clone() const { return TypedClass(read()); }
+
+  // The policy instance, for policies that record something
+  constexpr const Policy &policy() const { return *this; }
+
+private:
+  // For the probes: a link-time constant, where typeid(T).name() would be
+  // a load and a test on every call
+  static const std::type_info *type() { return &typeid(T); }
+
+  // Every read of val goes through here so the policy sees it
+  constexpr const T &read() const {
+    this->accessed();
+    return val;
+  }
+  constexpr T &read() {
+    this->accessed();
+    return val;
+  }
+};
@@ -19,7 +19,8 @@ int main() {
   //  side of an assignment operator. Examples include variables, function
   //  return values that are references, and dereferenced pointers.
   int x = 10; // `x` is an lvalue
-  int &y = x; // `y` is an lvalue reference, so it refers to the lvalue `x`
+  // `y` is an lvalue reference, so it refers to the lvalue `x`
+  [[maybe_unused]] int &y = x;
   *(&x) = 11; // The dereferenced pointer `*(&x)` is an lvalue
 
   // rvalue(right - hand side value)
@@ -27,22 +28,23 @@ int main() {
   //  temporary, unnamed object. It can only appear on the right side of an
   //  assignment operator. Examples include literals, function calls that return
   //  by value, and temporary objects.
-  int a = 5;            // `5` is an rvalue
-  int b = a + 2;        // `a + 2` is an rvalue
-  int c = std::move(a); // `std::move(a)` returns an rvalue reference
+  int a = 5;                             // `5` is an rvalue
+  [[maybe_unused]] int b = a + 2;        // `a + 2` is an rvalue
+  [[maybe_unused]] int c = std::move(a); // `std::move(a)` returns an rvalue
+                                         // reference
 
   // prvalue (pure rvalue)
   //  A prvalue is the most basic type of rvalue. It is an expression that
   //  creates a temporary object. All rvalues are either prvalues or xvalues.
-  int d = 10;      // `10` is a prvalue
-  int sum = 1 + 2; // `1 + 2` is a prvalue
+  [[maybe_unused]] int d = 10;      // `10` is a prvalue
+  [[maybe_unused]] int sum = 1 + 2; // `1 + 2` is a prvalue
 
   // xvalue (expiring value)
   //  An xvalue is an rvalue that refers to an object that can be moved from. It
   //  is typically created by casting an lvalue to an rvalue reference. This is
   //  what std::move does.
-  int e = 10;
-  int f = std::move(x); // `std::move(x)` is an xvalue
+  [[maybe_unused]] int e = 10;
+  [[maybe_unused]] int f = std::move(x); // `std::move(x)` is an xvalue
 
   /* NOTE:
      - An lvalue is an object you can name and find a memory address for.
@@ -86,6 +88,10 @@ int main() {
   //  Optimization (RVO), std::move can be used to explicitly move local
   //  variables out of a function. However, using it on named return values can
   //  sometimes inhibit RVO and decrease performance.
+  //
+  //  bench/moveSemanticsBench.cpp measures each of these (copy, move, RVO,
+  //  NRVO, std::move on return) for vectors, strings, DynamicArray and
+  //  TypedClass, together with the allocations they perform.
 
   // Limitations
   //  Doesn't Always Move: std::move is just a cast. If the object you are
@@ -108,5 +114,7 @@ int main() {
   //  Final Use: Once you have moved from an object, it shouldn't be use it
   //  anymore, with the exception of assigning a new value to it or letting it
   //  go out of scope. Using a moved-from object can lead to undefined behavior.
+  //  TypedClass<T, MoveCheckPolicy> (moveCheckPolicy.hpp) traps on such uses
+  //  in debug builds.
   return 0;
 }
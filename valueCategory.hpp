@@ -0,0 +1,90 @@
+#pragma once
+
+// Compile-time answers to the questions valueCategories.cpp explains in
+// comments: what value category is this expression, and would initializing
+// an object from it copy, move, or construct in place?
+//
+//   VALUE_CATEGORY_OF(x)             -> ValueCategory::LValue
+//   VALUE_CATEGORY_OF(std::move(x))  -> ValueCategory::XValue
+//   VALUE_CATEGORY_OF(x + 1)         -> ValueCategory::PRValue
+//
+//   auto big = NO_COPY(makeArray());      // fine: prvalue, elided
+//   auto big = NO_COPY(std::move(other)); // fine: moved
+//   auto big = NO_COPY(other);            // compile error: would copy
+//
+// decltype((e)) (note the double parentheses) is the whole trick: it yields
+// T& for lvalues, T&& for xvalues and plain T for prvalues.
+
+#include "typedClass.hpp"
+
+#include <type_traits>
+
+enum class ValueCategory { LValue, XValue, PRValue };
+
+template <class DeclType>
+inline constexpr ValueCategory value_category_v = ValueCategory::PRValue;
+template <class T>
+inline constexpr ValueCategory value_category_v<T &> = ValueCategory::LValue;
+template <class T>
+inline constexpr ValueCategory value_category_v<T &&> = ValueCategory::XValue;
+
+#define VALUE_CATEGORY_OF(...) (value_category_v<decltype((__VA_ARGS__))>)
+
+// How `T obj = e;` initializes obj, given DeclType = decltype((e)).
+// Elided means no copy or move constructor runs at all (guaranteed since
+// C++17 for a prvalue of type T).
+enum class Selected { Elided, Copy, Move, Other };
+
+template <class T, class DeclType>
+constexpr Selected selectedConstructor() {
+  using U = std::remove_cvref_t<DeclType>;
+  if constexpr (!std::is_same_v<U, std::remove_cv_t<T>>)
+    return Selected::Other; // a converting constructor, not copy/move
+  else if constexpr (!std::is_reference_v<DeclType>)
+    return Selected::Elided;
+  else if constexpr (std::is_lvalue_reference_v<DeclType> ||
+                     std::is_const_v<std::remove_reference_t<DeclType>>)
+    return Selected::Copy; // const T&& can't bind to T&&
+  else
+    return Selected::Move;
+}
+
+// Only looks at the expression: a type with no move constructor still
+// copies from an xvalue. TypedClass and DynamicArray both have one, which
+// valueCategoryChecks.cpp verifies by actually running the constructors at
+// compile time with TracePolicy.
+template <class T, class DeclType>
+inline constexpr Selected selected_constructor_v =
+    selectedConstructor<T, DeclType>();
+
+template <class DeclType>
+inline constexpr bool would_copy_v =
+    selected_constructor_v<std::remove_cvref_t<DeclType>, DeclType> ==
+    Selected::Copy;
+
+// A no-copy contract: evaluates to the expression itself (same value
+// category, so prvalues are still elided), but fails to compile if using it
+// to initialize an object would invoke a copy constructor.
+#define NO_COPY(...)                                                           \
+  ([&]() -> decltype(auto) {                                                   \
+    static_assert(!would_copy_v<decltype((__VA_ARGS__))>,                      \
+                  "NO_COPY: this expression would be copied; std::move it "    \
+                  "or clone explicitly");                                      \
+    return (__VA_ARGS__);                                                      \
+  }())
+
+// A TypedClass policy that remembers which constructor created the object,
+// without printing anything. All of it is constexpr, so constructions can be
+// checked with static_assert:
+//   static_assert([] {
+//     TypedClass<int, TracePolicy> a{1};
+//     TypedClass<int, TracePolicy> b = std::move(a);
+//     return b.policy().how;
+//   }() == Construction::Move);
+struct TracePolicy : SilentPolicy {
+  Construction how = Construction::Default;
+
+  template <class T> constexpr void constructed(Construction c, const T &) {
+    how = c;
+  }
+};
@@ -0,0 +1,123 @@
+/*
+ * NOTE: Value categories, checked by the compiler
+ * valueCategories.cpp explains lvalues, xvalues and prvalues in comments.
+ * Here the same claims are written as static_asserts, so this file only
+ * compiles if they hold. The constructor checks run TypedClass and
+ * DynamicArray constructors inside constant evaluation with TracePolicy,
+ * which records which constructor actually ran.
+ */
+
+#include "dynamicArray.hpp"
+#include "valueCategory.hpp"
+
+#include <iostream>
+#include <utility>
+
+using Traced = TypedClass<int, TracePolicy>;
+
+// --- Value categories -------------------------------------------------------
+constexpr int f() { return 1; }
+constexpr int &g(int &x) { return x; }
+
+static_assert([] {
+  int x = 10;
+  int &y = x;
+  return VALUE_CATEGORY_OF(x) == ValueCategory::LValue &&
+         VALUE_CATEGORY_OF(y) == ValueCategory::LValue &&
+         VALUE_CATEGORY_OF(*(&x)) == ValueCategory::LValue &&
+         VALUE_CATEGORY_OF(g(x)) == ValueCategory::LValue &&
+         VALUE_CATEGORY_OF(std::move(x)) == ValueCategory::XValue &&
+         VALUE_CATEGORY_OF(10) == ValueCategory::PRValue &&
+         VALUE_CATEGORY_OF(x + 2) == ValueCategory::PRValue &&
+         VALUE_CATEGORY_OF(f()) == ValueCategory::PRValue;
+}());
+
+// --- Which constructor an expression selects, from its type alone ----------
+static_assert(selected_constructor_v<Traced, Traced &> == Selected::Copy);
+static_assert(selected_constructor_v<Traced, const Traced &> == Selected::Copy);
+static_assert(selected_constructor_v<Traced, Traced &&> == Selected::Move);
+static_assert(selected_constructor_v<Traced, const Traced &&> == Selected::Copy);
+static_assert(selected_constructor_v<Traced, Traced> == Selected::Elided);
+static_assert(selected_constructor_v<Traced, int> == Selected::Other);
+
+// --- ... and confirmed by running the constructors --------------------------
+constexpr Construction constructedBy(const Traced &t) { return t.policy().how; }
+
+// Copy from an lvalue
+static_assert([] {
+  Traced a{1};
+  Traced b = a;
+  return constructedBy(b);
+}() == Construction::Copy);
+
+// Move from an xvalue: TypedClass really has a move constructor, rather than
+// std::move silently falling back to the copy constructor
+static_assert([] {
+  Traced a{1};
+  Traced b = std::move(a);
+  return constructedBy(b);
+}() == Construction::Move);
+
+// A const xvalue can't be moved from
+static_assert([] {
+  const Traced a{1};
+  Traced b = std::move(a);
+  return constructedBy(b);
+}() == Construction::Copy);
+
+// Initialization from a prvalue: elided, only the value constructor ran
+static_assert([] {
+  Traced b = Traced{1};
+  return constructedBy(b);
+}() == Construction::Value);
+
+constexpr Traced makeTraced() { return Traced{7}; }
+static_assert(constructedBy(makeTraced()) == Construction::Value);
+
+// Copying a DynamicArray copies every element...
+static_assert([] {
+  DynamicArray<Traced> a;
+  a.emplace_back(1);
+  DynamicArray<Traced> b = a;
+  return constructedBy(b[0]) == Construction::Copy && b.data() != a.data();
+}());
+
+// ...moving one steals the buffer: no element is constructed at all
+static_assert([] {
+  DynamicArray<Traced> a;
+  a.emplace_back(1);
+  const Traced *buffer = a.data();
+  DynamicArray<Traced> b = std::move(a);
+  return constructedBy(b[0]) == Construction::Value && b.data() == buffer;
+}());
+
+// The same, through NO_COPY: these compile; NO_COPY(a) would not
+static_assert([] {
+  DynamicArray<Traced> a;
+  a.emplace_back(1);
+  const Traced *buffer = a.data();
+  DynamicArray<Traced> b = NO_COPY(std::move(a));
+  DynamicArray<Traced> c = NO_COPY(DynamicArray<Traced>(2));
+  return b.data() == buffer && c.size() == 2;
+}());
+static_assert(would_copy_v<DynamicArray<int> &>);
+static_assert(!would_copy_v<DynamicArray<int> &&>);
+static_assert(!would_copy_v<DynamicArray<int>>);
+
+const char *name(ValueCategory c) {
+  return c == ValueCategory::LValue   ? "lvalue"
+         : c == ValueCategory::XValue ? "xvalue"
+                                      : "prvalue";
+}
+
+int main() {
+  // Everything above was already checked during compilation; this just shows
+  // the same classification at run time.
+  int x = 10;
+  std::cout << "x            is an " << name(VALUE_CATEGORY_OF(x)) << std::endl;
+  std::cout << "std::move(x) is an " << name(VALUE_CATEGORY_OF(std::move(x)))
+            << std::endl;
+  std::cout << "x + 2        is a  " << name(VALUE_CATEGORY_OF(x + 2))
+            << std::endl;
+  return 0;
+}